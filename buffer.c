@@ -28,37 +28,168 @@
  *			b_getcoffset()
  *			b_rewind()
  *			b_location()
+ *			b_reserve()
+ *			b_addn()
+ *			b_view()
+ *			b_source()
+ *			b_insert()
+ *			b_delete()
+ *			b_stats()
+ *			b_release()
+ *			b_share()
+ *			b_grow_add()
+ *			b_grow_mul()
+ *			b_map()
+ *			b_growth()
+ *			b_next()
+ *			b_mulinc()
+ *			b_resize()
+ *			b_realloc()
+ *			b_fit()
+ *			b_filesize()
+ *			b_addseg()
+ *			b_at()
+ *			b_run()
+ *			b_fill()
+ *			b_fread()
+ *			b_gapmove()
+ *			b_takehandle()
+ *			b_takeblock()
+ *			b_dropblock()
  */
 
+/* b_map() and b_filesize() use POSIX names (mmap(), MAP_ANONYMOUS, madvise(), fileno()) that a strict ISO C
+   build (-std=c99) hides unless they are asked for before the first include */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE		/* MAP_ANONYMOUS and madvise() on glibc */
+#define _DARWIN_C_SOURCE	/* MAP_ANON and madvise() on macOS */
+#endif
+
+#include <string.h>		/* memcpy(), memmove(), memset() */
+
 #include "buffer.h"
 
+#ifdef _WIN32
+#include <io.h>			/* _fileno() */
+#include <sys/stat.h>	/* _fstat64() */
+#include <intrin.h>		/* _InterlockedIncrement(), _InterlockedDecrement() */
+#define B_THREAD __declspec(thread)
+#define B_ADDREF(share) _InterlockedIncrement(&(share)->refs)
+#define B_DROPREF(share) _InterlockedDecrement(&(share)->refs)
+#else
+#include <sys/mman.h>	/* mmap(), munmap() */
+#include <sys/stat.h>	/* fstat() */
+#include <unistd.h>		/* sysconf() */
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON	/* the older BSD name */
+#endif
+#define B_THREAD __thread
+#define B_ADDREF(share) __atomic_add_fetch(&(share)->refs, 1, __ATOMIC_RELAXED)
+#define B_DROPREF(share) __atomic_sub_fetch(&(share)->refs, 1, __ATOMIC_ACQ_REL)
+#endif
+
+/* chars shared by the SHARED_MODE cursors b_share() hands out. The count is only ever changed atomically */
+struct BufferShare {
+	volatile long refs; /* # of cursors still reading the chars */
+	char* head;			/* the chars, freed with the last cursor */
+	size_t mapped;		/* length of the mapping if head was mapped by b_map(), 0 if it was allocated */
+};
+
+static size_t b_map(FILE* const fi, Buffer* const pBD);
+static size_t b_growth(Buffer* const pBD);
+static size_t b_next(size_t capacity, size_t increment);
+static size_t b_mulinc(size_t capacity, char inc_factor);
+static pBuffer b_resize(Buffer* const pBD, size_t new_capacity);
+static pBuffer b_realloc(Buffer* const pBD, size_t new_capacity);
+static pBuffer b_fit(Buffer* const pBD, size_t n);
+static size_t b_filesize(FILE* const fi);
+static pBuffer b_addseg(Buffer* const pBD);
+static char* b_at(Buffer* const pBD, size_t offset);
+static size_t b_run(Buffer* const pBD, size_t offset);
+static size_t b_fill(Buffer* const pBD);
+static size_t b_fread(void* source, char* dst, size_t n);
+static void b_gapmove(Buffer* const pBD, size_t offset);
+static pBuffer b_takehandle(void);
+static char* b_takeblock(Buffer* const pBD, size_t size);
+static void b_dropblock(Buffer* const pBD);
+
+/* handlers and small char buffers kept by b_free() for the next b_allocate(). Each thread has its own
+   pool, so threads scanning different sources never share one. Pooled handlers are linked through their
+   source member and pooled char buffers through their first bytes. */
+static B_THREAD pBuffer b_handles;						/* free handlers */
+static B_THREAD size_t b_handle_count;					/* # of free handlers */
+static B_THREAD char* b_blocks[POOL_CLASSES];			/* free char buffers of 1 << (class + POOL_MIN_SHIFT) bytes */
+static B_THREAD size_t b_block_count[POOL_CLASSES];		/* # of free char buffers of each size */
+
+#ifdef B_STATS
+static B_THREAD BufferStats b_totals; /* counters of all the buffers the thread freed so far, see b_stats() */
+#endif
+
 /*
- *	Purpose: Dynamically allocates a buffer handler and initializes it's properties
+ *	Purpose: Dynamically allocates a buffer handler and initializes it's properties.
+ *			 Handlers and small char buffers freed earlier are reused, see b_free().
  *	Author : Alex Carrozzi
- *	History / Versions: 1.0
- *	Called functions : calloc(), malloc(), free()
- *	Parameters : init_capacity: short, unit of measurement is in BYTES and should be positive
- *				 inc_factor: char, unit of measurement is in BYTES in ADDITIVE_MODE, percentage in MULTIPLICATIVE_MODE from 1-100 inclusive
- *				 o_mode: char, should be char 'a' or 'm' or 'f' case sensitive
+ *	History / Versions: 1.2 GAP_MODE, pooled handlers and char buffers
+ *	Called functions : b_takehandle(), b_takeblock(), malloc(), free()
+ *	Parameters : init_capacity: size_t, unit of measurement is in BYTES and should not exceed MAX_BUF_CAPACITY
+ *				 inc_factor: char, unit of measurement is in BYTES in ADDITIVE_MODE, percentage in MULTIPLICATIVE_MODE and GAP_MODE
+ *							 from 1-100 inclusive (0 picks DEFAULT_INC_FACTOR in GAP_MODE)
+ *				 o_mode: char, should be char 'a' or 'm' or 'f' or 'r' or 's' or 'i' or 'g' case sensitive. 'r' ignores the other parameters,
+ *						 's' and 'i' only use init_capacity, rounded up to whole segments or a power of two ring size
  *	Return value : A valid pointer to a buffer handler or NULL if error
  *	Algorithm : N/A
  */
-Buffer* b_allocate(short init_capacity, char inc_factor, char o_mode)
+Buffer* b_allocate(size_t init_capacity, char inc_factor, char o_mode)
 {
 	pBuffer pBuf; /* a pointer to the buffer handler, not yet instantiated */
 
-	/* as per the documentation, init_capacity must be between 0 and SHRT_MAX -1 inclusive */
-	if (init_capacity < 0 || init_capacity > MAX_BUF_CAPACITY)
+	/* init_capacity must be between 0 and MAX_BUF_CAPACITY inclusive */
+	if (init_capacity > MAX_BUF_CAPACITY)
 		return NULL;
 
 	/* dynamically allocate buffer handler, return NULL if call to calloc() fails (returns NULL)
 		ignore warning: assignment within condition expression  -- I've used parenthesis */
-	if (!(pBuf = (Buffer*)calloc(1, sizeof(Buffer))))
+	if (!(pBuf = b_takehandle()))
 		return NULL;
 
+	/* a read-only buffer has no character buffer until b_load() maps the source file into memory */
+	if (o_mode == 'r') {
+		pBuf->mode = READONLY_MODE;
+		pBuf->flags = DEFAULT_FLAGS;
+		return pBuf;
+	}
+
+	/* a segmented buffer allocates its segments as chars are added, reserve init_capacity up front */
+	if (o_mode == 's') {
+		pBuf->mode = SEGMENTED_MODE;
+		pBuf->flags = DEFAULT_FLAGS;
+		if (b_fit(pBuf, init_capacity) == NULL) {
+			b_free(pBuf);
+			return NULL;
+		}
+		return pBuf;
+	}
+
+	/* a stream buffer is a ring, its size must be a power of two so offsets can be masked */
+	if (o_mode == 'i') {
+		if (init_capacity == 0)
+			init_capacity = DEFAULT_INIT_CAPACITY;
+		for (pBuf->capacity = 1; pBuf->capacity < init_capacity && pBuf->capacity <= MAX_BUF_CAPACITY / 2; pBuf->capacity <<= 1)
+			;
+		if (!(pBuf->cb_head = (char*)malloc(pBuf->capacity))) {
+			free(pBuf);
+			return NULL;
+		}
+		pBuf->mode = STREAM_MODE;
+		pBuf->flags = DEFAULT_FLAGS;
+		pBuf->eos = -1;
+		return pBuf;
+	}
+
 	/* dynamically allocate character buffer, free handler and return NULL if call to malloc() fails (returns NULL)
 		ignore warning: assignment within condition expression  -- I've used parenthesis */
-	if (!(pBuf->cb_head = (char*)malloc(init_capacity == 0 ? DEFAULT_INIT_CAPACITY : init_capacity))) {
+	if (!(pBuf->cb_head = b_takeblock(pBuf, init_capacity == 0 ? DEFAULT_INIT_CAPACITY : init_capacity))) {
 		free(pBuf);
 		return NULL;
 	}
@@ -78,12 +209,21 @@ Buffer* b_allocate(short init_capacity, char inc_factor, char o_mode)
 			pBuf->inc_factor = 0;
 			break;
 
+		case 'g': pBuf->mode = GAP_MODE;
+			pBuf->inc_factor = DEFAULT_INC_FACTOR;
+			break;
+
 			/* invalid o_mode parameter, free handler and char buffer then return NULL */
 		default:  free(pBuf->cb_head);
 			free(pBuf);
 			return NULL;
 		}
 	}
+	/* a gap buffer must be able to grow, b_insert() is its only way to add chars */
+	else if (o_mode == 'g' && (unsigned char)inc_factor <= 100) {
+		pBuf->mode = GAP_MODE;
+		pBuf->inc_factor = (inc_factor == 0) ? DEFAULT_INC_FACTOR : inc_factor;
+	}
 	else if (inc_factor == 0 || o_mode == 'f') {
 		pBuf->mode = FIXED_MODE;
 		pBuf->inc_factor = 0;
@@ -105,7 +245,7 @@ Buffer* b_allocate(short init_capacity, char inc_factor, char o_mode)
 		return NULL;
 	}
 	pBuf->capacity = (init_capacity == 0) ? DEFAULT_INIT_CAPACITY : init_capacity;
-	pBuf->flags = DEFAULT_FLAGS;
+	pBuf->flags = (pBuf->flags & CHECK_POOL) | DEFAULT_FLAGS;
 	pBuf->addc_offset = pBuf->getc_offset = pBuf->markc_offset = 0; /* not mentioned the specification for this function but it seems reasonable to include */
 	return pBuf;
 }
@@ -114,8 +254,8 @@ Buffer* b_allocate(short init_capacity, char inc_factor, char o_mode)
 /*
  *	Purpose: Adds the char, symbol, to the buffer if there is space. Attempts to increase the capacity of the buffer if it is full.
  *	Author : Alex Carrozzi
- *	History / Versions: 1.0
- *	Called functions : realloc()
+ *	History / Versions: 1.3 SEGMENTED_MODE, GAP_MODE
+ *	Called functions : b_growth(), b_resize(), b_addseg(), b_insert()
  *	Parameters : pBuffer: A valid pointer to a Buffer structure
  *				 symbol: char, ranging from -128 - 127 inclusive
  *	Return value : A valid pointer to a buffer handler or NULL if error
@@ -123,53 +263,26 @@ Buffer* b_allocate(short init_capacity, char inc_factor, char o_mode)
  */
 pBuffer b_addc(pBuffer const pBD, char symbol)
 {
-	if (pBD == NULL) return NULL;
-
-	/* realloc_ptr will store the return value of realloc() to avoid a potential dangling pointer
-		it is also used to check if the block of memory was moved so we can set the r_flag accordingly */
-	void* realloc_ptr;
-	short new_capacity; /* if the capacity needs to be increased because the buffer is full, new_capacity is used in the calculations */
+	if (pBD == NULL || pBD->mode == READONLY_MODE || pBD->mode == STREAM_MODE || pBD->mode == SHARED_MODE) return NULL;
 
 	pBD->flags &= RESET_R_FLAG; /* assume no realloction to start */
 
-	/* check if buffer is full */
-	if (pBD->addc_offset == pBD->capacity) {
-
-		/* check if capacity already maxed out (SHRT_MAX or SHRT_MAX - 1)*/
-		if (pBD->capacity >= MAX_BUF_CAPACITY)
+	if (pBD->mode == SEGMENTED_MODE) {
+		if (pBD->addc_offset == pBD->capacity && b_addseg(pBD) == NULL)
 			return NULL;
+		pBD->segs[pBD->addc_offset >> SEGMENT_SHIFT][pBD->addc_offset & SEGMENT_MASK] = symbol;
+		++pBD->addc_offset;
+		return pBD;
+	}
 
-		/* capacity can be increased, check mode of handler and run the appropriate algorithm */
-		switch (pBD->mode) {
-
-		case ADDITIVE_MODE:	new_capacity = pBD->capacity + (unsigned char)pBD->inc_factor;
-			if (new_capacity < 0)
-				return NULL;
-			/* it's possible the new_capacity exceeded MAX_BUF_CAPACITY without overflowing */
-			new_capacity = new_capacity == SHRT_MAX ? MAX_BUF_CAPACITY : new_capacity;
-			break;
-
-			/* need at least 4 bytes to store the maximum possible value of the multiplication, hence the cast to long*/
-		case MULTIPLICATIVE_MODE:  new_capacity = (MAX_BUF_CAPACITY - pBD->capacity) * (long)pBD->inc_factor / 100;
-			new_capacity = (new_capacity == 0 || new_capacity + (long)pBD->capacity > MAX_BUF_CAPACITY) ? MAX_BUF_CAPACITY : (new_capacity + pBD->capacity);
-			break;
-
-			/* catches FIXED_MODE */
-		default:  return NULL;
-			break;
-		}
+	/* the gap may not be at the end, appending is an insert at addc_offset */
+	if (pBD->mode == GAP_MODE)
+		return b_insert(pBD, pBD->addc_offset, &symbol, 1);
 
-		/* assign pointer returned from realloc() to realloc_ptr, if NULL then return NULL */
-		if (!(realloc_ptr = realloc(pBD->cb_head, new_capacity)))
-			return NULL;
+	/* if the buffer is full, the mode decides if and how much it can grow */
+	if (pBD->addc_offset == pBD->capacity && b_resize(pBD, b_growth(pBD)) == NULL)
+		return NULL;
 
-		/* check if the starting address was moved, if so, set R_FLAG and assign cb_head the new starting address */
-		if (pBD->cb_head != (char*)realloc_ptr) {
-			pBD->flags |= SET_R_FLAG;
-			pBD->cb_head = (char*)realloc_ptr;
-		}
-		pBD->capacity = new_capacity;
-	}
 	pBD->cb_head[pBD->addc_offset++] = symbol; /* append symbol to the char buffer and increment addc_offset */
 	return pBD;
 }
@@ -186,18 +299,22 @@ pBuffer b_addc(pBuffer const pBD, char symbol)
  */
 int b_clear(Buffer* const pBD)
 {
-	if (pBD == NULL)  return RT_FAIL_1;
+	if (pBD == NULL || pBD->mode == SHARED_MODE)  return RT_FAIL_1;
 
 	/* pBD->flags = DEFAULT_FLAGS;  not sure about this */
+	pBD->flags &= RESET_PAD; /* the sentinel is gone */
+	pBD->gap_tail = 0;
 	return pBD->addc_offset = pBD->getc_offset = pBD->markc_offset = 0; /* asscoiativity of assignment operator is right to left */
 }
 
 
 /*
- *	Purpose: De-allocates the char buffer and the buffer handler from memory
+ *	Purpose: De-allocates the char buffer and the buffer handler from memory.
+ *			 Up to POOL_DEPTH handlers and pooled char buffers of each size are kept for the next b_allocate().
  *	Author : Alex Carrozzi
- *	History / Versions: 1.0
- *	Called functions : free()
+ *	History / Versions: 1.5 unmaps READONLY_MODE buffers, frees each segment of SEGMENTED_MODE buffers,
+ *						adds the buffer's counters to the totals with B_STATS, pooling, SHARED_MODE
+ *	Called functions : free(), munmap(), b_dropblock()
  *	Parameters : pBD: A valid pointer to a Buffer structure
  *	Return value : N/A
  *	Algorithm : N/A
@@ -205,8 +322,48 @@ int b_clear(Buffer* const pBD)
 void b_free(Buffer* const pBD)
 {
 	if (pBD == NULL)  return;
-	free(pBD->cb_head); /* free the char buffer before the handler structure, OF COUUUURRSE */
-	free(pBD);
+
+	/* a cursor only drops its reference, the last one frees the chars. It never touches the pool
+		so each cursor can be freed by the thread reading it */
+	if (pBD->mode == SHARED_MODE) {
+		if (B_DROPREF(pBD->share) == 0) {
+#ifndef _WIN32
+			if (pBD->share->mapped > 0)
+				munmap(pBD->share->head, pBD->share->mapped);
+			else
+#endif
+				free(pBD->share->head);
+			free(pBD->share);
+		}
+		free(pBD);
+		return;
+	}
+#ifdef B_STATS
+	B_PEAK(pBD);
+	b_totals.grows += pBD->stats.grows;
+	b_totals.moves += pBD->stats.moves;
+	b_totals.copied += pBD->stats.copied;
+	b_totals.peak = (pBD->stats.peak > b_totals.peak) ? pBD->stats.peak : b_totals.peak;
+	b_totals.getcs += pBD->stats.getcs;
+	b_totals.retracts += pBD->stats.retracts;
+#endif
+	while (pBD->seg_count > 0)
+		free(pBD->segs[--pBD->seg_count]);
+	free(pBD->segs);
+#ifndef _WIN32
+	if (pBD->mode == READONLY_MODE && pBD->cb_head != NULL) {
+		munmap(pBD->cb_head, pBD->capacity + SENTINEL_PAD); /* covers the whole mapping, munmap() rounds it up to pages */
+		pBD->cb_head = NULL;
+	}
+#endif
+	b_dropblock(pBD); /* free the char buffer before the handler structure, OF COUUUURRSE */
+	if (b_handle_count == POOL_DEPTH) {
+		free(pBD);
+		return;
+	}
+	pBD->source = b_handles;
+	b_handles = pBD;
+	++b_handle_count;
 }
 
 
@@ -233,7 +390,7 @@ int b_isfull(Buffer* const pBD)
  *	Return value : -1 on error, otherwise returns the limit of the buffer
  *	Algorithm : N/A
  */
-short b_limit(Buffer* const pBD)
+size_t b_limit(Buffer* const pBD)
 {
 	return (pBD == NULL) ? RT_FAIL_1 : pBD->addc_offset;
 }
@@ -248,7 +405,7 @@ short b_limit(Buffer* const pBD)
  *	Return value : 0 on success, -1 if NULL ptr is passed
  *	Algorithm : N/A
  */
-short b_capacity(Buffer* const pBD)
+size_t b_capacity(Buffer* const pBD)
 {
 	return (pBD == NULL) ? RT_FAIL_1 : pBD->capacity;
 }
@@ -263,10 +420,10 @@ short b_capacity(Buffer* const pBD)
  *	Return value : -1 on error, mark otherwise
  *	Algorithm : N/A
  */
-short b_mark(pBuffer const pBD, short mark)
+size_t b_mark(pBuffer const pBD, size_t mark)
 {
 	/* bound check the mark parameter first, if OK then assign to markc_offset and return it's value */
-	return ((pBD == NULL) || (unsigned short)mark > pBD->addc_offset) ? RT_FAIL_1 : (pBD->markc_offset = mark);
+	return ((pBD == NULL) || mark > pBD->addc_offset) ? RT_FAIL_1 : (pBD->markc_offset = mark);
 }
 
 
@@ -302,32 +459,66 @@ size_t b_incfactor(Buffer* const pBD)
 
 
 /*
- *	Purpose: Populates the char buffer one char at a time by reading from FILE param fi
+ *	Purpose: Populates the char buffer by reading from FILE param fi in blocks.
+ *			 A READONLY_MODE buffer maps the whole file instead.
+ *			 A STREAM_MODE buffer only reads its first ring-full, the rest is read as b_getc() needs it.
+ *			 fi must then stay open until the buffer has been read to the end.
  *	Author : Alex Carrozzi
- *	History / Versions: 1.0
- *	Called functions : N/A
+ *	History / Versions: 1.4 block reads, presized from the file size, GAP_MODE
+ *	Called functions : b_map(), b_filesize(), b_gapmove(), b_fit(), b_addc(), b_at(), fread(), fgetc(), ungetc()
  *	Parameters : fi: A valid pointer to a FILE struct
  *				 pBD: A valid pointer to a Buffer structure
- *	Return value : NULL if null fi or buffer ptr, -2 if file too big, number of chars added to char buffer otherwise
- *	Algorithm : N/A
+ *	Return value : -1 if null fi or buffer ptr, -2 if file too big, number of chars added to char buffer otherwise
+ *	Algorithm : If the size of the file is known, grow the buffer once to hold the rest of the file plus
+ *				the sentinel b_compact() will append. Then fread() straight into the free space of the char
+ *				buffer (one segment at a time in SEGMENTED_MODE), growing by the mode's increment whenever it
+ *				fills up before the end of the file. A gap buffer first moves its gap to the end.
  */
-int b_load(FILE* const fi, Buffer* const pBD)
+size_t b_load(FILE* const fi, Buffer* const pBD)
 {
 	/* valid pointer check */
-	if (fi == NULL || pBD == NULL)  return RT_FAIL_1;
+	if (fi == NULL || pBD == NULL || pBD->mode == SHARED_MODE)  return RT_FAIL_1;
 
-	char c; /* stores char read from file fi */
-	int count = 0; /* # of characters added to buffer successfully */
-	for (;;) {
-		c = fgetc(fi);
-		if (feof(fi))
-			return count;
+	if (pBD->mode == READONLY_MODE)
+		return b_map(fi, pBD);
+
+	if (pBD->mode == STREAM_MODE)
+		return (b_source(pBD, b_fread, fi) == NULL) ? RT_FAIL_1 : b_fill(pBD);
+
+	int c; /* stores char read from file fi when the buffer is full */
+	size_t count = 0; /* # of characters added to buffer successfully */
+	size_t remaining = b_filesize(fi); /* bytes left in the file, 0 if unknown */
+	size_t read; /* # of chars read by the last call to fread() */
 
-		if (b_addc(pBD, c) == NULL) {
-			ungetc(c, fi);
-			return LOAD_FAIL;
+	pBD->flags &= RESET_R_FLAG;
+	if (pBD->mode == GAP_MODE)
+		b_gapmove(pBD, pBD->addc_offset);
+
+	/* reserve the final capacity up front, a FIXED_MODE buffer keeps its capacity */
+	if (pBD->mode != FIXED_MODE && remaining > 0 && remaining < MAX_BUF_CAPACITY - pBD->addc_offset)
+		b_fit(pBD, remaining + 1); /* failure is not fatal, fall back to growing as we go */
+
+	for (;;) {
+		/* buffer is full, make sure there is something left to read before growing it */
+		if (pBD->addc_offset == pBD->capacity) {
+			if ((c = fgetc(fi)) == EOF)
+				return count;
+			if (b_addc(pBD, (char)c) == NULL) {
+				ungetc(c, fi);
+				return LOAD_FAIL;
+			}
+			++count;
 		}
-		++count;
+
+		/* never read past the end of the current segment */
+		read = pBD->capacity - pBD->addc_offset;
+		if (read > b_run(pBD, pBD->addc_offset))
+			read = b_run(pBD, pBD->addc_offset);
+		read = fread(b_at(pBD, pBD->addc_offset), 1, read, fi);
+		pBD->addc_offset += read;
+		count += read;
+		if (read == 0)
+			return count;
 	}
 }
 
@@ -342,6 +533,9 @@ int b_load(FILE* const fi, Buffer* const pBD)
  */
 int b_isempty(Buffer* const pBD)
 {
+	/* a stream buffer that hasn't been read from yet is only empty if its source is */
+	if (pBD != NULL && pBD->mode == STREAM_MODE && pBD->addc_offset == 0)
+		b_fill(pBD);
 	return (pBD == NULL) ? RT_FAIL_1 : (pBD->addc_offset == 0);
 }
 
@@ -349,8 +543,8 @@ int b_isempty(Buffer* const pBD)
 /*
  *	Purpose: Returns the char from the buffer indexed with getc_offset
  *	Author : Alex Carrozzi
- *	History / Versions: 1.0
- *	Called functions : N/A
+ *	History / Versions: 1.3 SEGMENTED_MODE, STREAM_MODE refills the ring when it runs out of chars, GAP_MODE skips the gap
+ *	Called functions : b_fill()
  *	Parameters : pBD: A valid pointer to a Buffer structure
  *	Return value : -2 if null buffer ptr, 0 if can't read more chars from buffer, the char read from the buffer otherwise
  *	Algorithm : N/A
@@ -358,14 +552,23 @@ int b_isempty(Buffer* const pBD)
 char b_getc(Buffer* const pBD)
 {
 	if (pBD == NULL)  return RT_FAIL_2;
+	B_COUNT(pBD, getcs, 1);
 
 	/* check if we can read another character from the buffer */
-	if (pBD->getc_offset == pBD->addc_offset) {
+	if (pBD->getc_offset == pBD->addc_offset && (pBD->mode != STREAM_MODE || b_fill(pBD) == 0)) {
 		pBD->flags |= SET_EOB;
 		return 0; 
 	}
 
 	pBD->flags &= RESET_EOB;
+	if (pBD->mode == SEGMENTED_MODE) {
+		++pBD->getc_offset;
+		return pBD->segs[(pBD->getc_offset - 1) >> SEGMENT_SHIFT][(pBD->getc_offset - 1) & SEGMENT_MASK];
+	}
+	if (pBD->mode == STREAM_MODE)
+		return pBD->cb_head[pBD->getc_offset++ & (pBD->capacity - 1)];
+	if (pBD->mode == GAP_MODE && pBD->getc_offset >= pBD->addc_offset - pBD->gap_tail)
+		return pBD->cb_head[pBD->getc_offset++ + (pBD->capacity - pBD->addc_offset)];
 	return pBD->cb_head[pBD->getc_offset++];
 }
 
@@ -395,11 +598,11 @@ int b_eob(Buffer* const pBD)
  *	Return value : -1 if null buffer ptr, the number of chars printed otherwise
  *	Algorithm : N/A
  */
-int b_print(Buffer* const pBD, char nl)
+size_t b_print(Buffer* const pBD, char nl)
 {
 	if (pBD == NULL)  return RT_FAIL_1;
 
-	int count; /* # of chars printed to the screen */
+	size_t count; /* # of chars printed to the screen */
 	char c; /* stores char read from buffer using b_getc() */
 	for (c = b_getc(pBD), count = 0; !b_eob(pBD); c = b_getc(pBD), ++count)
 		printf("%c", c);
@@ -411,39 +614,54 @@ int b_print(Buffer* const pBD, char nl)
 
 
 /*
- *	Purpose: Adds the char, symbol, to the buffer and resizes the capacity to be equal to the total number of chars added
+ *	Purpose: Adds the char, symbol, to the buffer and resizes the capacity to be equal to the total number of chars added.
+ *			 A READONLY_MODE buffer already has room for symbol past the mapped file so it is written in place.
+ *			 A contiguous buffer is also followed by SENTINEL_PAD zeroed bytes (not counted in the capacity)
+ *			 so the inline cursor in buffer.h can run over the end without a bounds check.
  *	Author : Alex Carrozzi
- *	History / Versions: 1.0
- *	Called functions : N/A
+ *	History / Versions: 1.4 READONLY_MODE, SEGMENTED_MODE, STREAM_MODE appends symbol once the source is exhausted,
+ *						sentinel padding
+ *	Called functions : b_resize(), b_addc(), memset()
  *	Parameters : pBD: A valid pointer to a Buffer structure
  *	Return value : NULL on error, the same Buffer pointer as the param pBD otherwise
  *	Algorithm : N/A
  */
 Buffer* b_compact(Buffer* const pBD, char symbol)
 {
-	if (pBD == NULL) return NULL;
-
-	/* realloc_ptr will store the return value of realloc() to avoid a potential dangling pointer
-	it is also used to check if the block of memory was moved so we can set the r_flag accordingly */
-	void* realloc_ptr;
+	if (pBD == NULL || pBD->mode == SHARED_MODE) return NULL;
 
 	pBD->flags &= RESET_R_FLAG; /* assume char buffer starting address is not moved to start */
 
 	/* buffer is full and can't be expanded */
-	if (pBD->addc_offset == SHRT_MAX)
+	if (pBD->addc_offset == MAX_BUF_CAPACITY)
 		return NULL;
 
-	/* realloc() the char buffer to exactly one byte bigger than addc_offset */
-	if (!(realloc_ptr = realloc(pBD->cb_head, pBD->addc_offset + 1)))
-		return NULL;
+	/* the mapping can't be resized, b_map() reserved exactly one byte past the file for the symbol */
+	if (pBD->mode == READONLY_MODE) {
+		if (pBD->cb_head == NULL || pBD->addc_offset == pBD->capacity)
+			return NULL;
+		pBD->cb_head[pBD->addc_offset++] = symbol;
+		pBD->flags |= SET_PAD;
+		return pBD;
+	}
 
-	/* did the starting address of the char buffer move? If it did, set the r_flag */
-	if (pBD->cb_head != realloc_ptr) {
-		pBD->flags |= SET_R_FLAG;
-		pBD->cb_head = (char*)realloc_ptr;
+	/* the end of a stream isn't known yet, b_fill() appends the symbol when the source runs dry */
+	if (pBD->mode == STREAM_MODE) {
+		pBD->eos = (unsigned char)symbol;
+		return pBD;
 	}
+
+	/* segments are never reallocated, the symbol simply goes after the last char */
+	if (pBD->mode == SEGMENTED_MODE)
+		return b_addc(pBD, symbol);
+
+	/* realloc() the char buffer to exactly one byte bigger than addc_offset, plus the padding */
+	if (pBD->addc_offset > MAX_BUF_CAPACITY - 1 - SENTINEL_PAD || b_resize(pBD, pBD->addc_offset + 1 + SENTINEL_PAD) == NULL)
+		return NULL;
+	memset(pBD->cb_head + pBD->addc_offset + 1, 0, SENTINEL_PAD);
 	pBD->capacity = pBD->addc_offset + 1;
 	pBD->cb_head[pBD->addc_offset++] = symbol; /* append symbol to char buffer and increment addc_offset */
+	pBD->flags |= SET_PAD;
 	return pBD;
 }
 
@@ -471,8 +689,10 @@ char b_rflag(Buffer* const pBD)
  *	Return value : -1 if null buffer ptr, getc_offset after decrement otherwise
  *	Algorithm : N/A
  */
-short b_retract(Buffer* const pBD)
+size_t b_retract(Buffer* const pBD)
 {
+	if (pBD != NULL)
+		B_COUNT(pBD, retracts, 1);
 	return (pBD == NULL || pBD->getc_offset == 0) ? RT_FAIL_1 : --(pBD->getc_offset);
 }
 
@@ -486,7 +706,7 @@ short b_retract(Buffer* const pBD)
  *	Return value : -1 if null buffer ptr, getc_offset after assignment
  *	Algorithm : N/A
  */
-short b_reset(Buffer* const pBD)
+size_t b_reset(Buffer* const pBD)
 {
 	return (pBD == NULL) ? RT_FAIL_1 : (pBD->getc_offset = pBD->markc_offset);
 }
@@ -501,7 +721,7 @@ short b_reset(Buffer* const pBD)
  *	Return value : -1 if null buffer ptr, getc_offset otherwise
  *	Algorithm : N/A
  */
-short b_getcoffset(Buffer* const pBD)
+size_t b_getcoffset(Buffer* const pBD)
 {
 	return (pBD == NULL) ? RT_FAIL_1 : pBD->getc_offset;
 }
@@ -522,16 +742,832 @@ int b_rewind(Buffer* const pBD)
 }
 
 /*
- *	Purpose: Returns a pointer to the char buffer indication by markc_offset
+ *	Purpose: Returns a pointer to the char buffer indication by markc_offset.
+ *			 In SEGMENTED_MODE the chars are only contiguous up to the end of the mark's segment, see b_view().
  *	Author : Alex Carrozzi
- *	History / Versions: 1.0
- *	Called functions : N/A
+ *	History / Versions: 1.1 SEGMENTED_MODE
+ *	Called functions : b_at()
  *	Parameters : pBD: A valid pointer to a Buffer structure
  *	Return value : -1 if null buffer ptr, getc_offset after decrement otherwise
  *	Algorithm : N/A
  */ 
 char* b_location(Buffer* const pBD)
 {
-	return (pBD == NULL) ? NULL : (pBD->cb_head + pBD->markc_offset); /* pointer arithmetic, no dereferencing */
+	return (pBD == NULL) ? NULL : b_at(pBD, pBD->markc_offset);
+}
+
+
+/*
+ *	Purpose: Makes room for n more chars in the buffer so they can be added without growing the buffer again
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_fit()
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *				 n: size_t, the number of chars about to be added
+ *	Return value : NULL on error or if the mode doesn't allow the buffer to grow enough, pBD otherwise
+ *	Algorithm : N/A
+ */
+pBuffer b_reserve(pBuffer const pBD, size_t n)
+{
+	if (pBD == NULL || pBD->mode == READONLY_MODE || pBD->mode == STREAM_MODE || pBD->mode == SHARED_MODE) return NULL;
+
+	pBD->flags &= RESET_R_FLAG; /* assume no realloction to start */
+	return b_fit(pBD, n);
+}
+
+
+/*
+ *	Purpose: Adds n chars starting at src to the buffer, growing it at most once
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.1 GAP_MODE
+ *	Called functions : b_fit(), b_at(), memcpy(), b_insert()
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *				 src: const char*, the chars to add, must not point into the buffer itself
+ *				 n: size_t, the number of chars to add
+ *	Return value : NULL on error (nothing is added), pBD otherwise
+ *	Algorithm : N/A
+ */
+pBuffer b_addn(pBuffer const pBD, const char* src, size_t n)
+{
+	if (pBD == NULL || pBD->mode == READONLY_MODE || pBD->mode == STREAM_MODE || pBD->mode == SHARED_MODE
+		|| (src == NULL && n > 0)) return NULL;
+
+	size_t part; /* # of chars copied into the current segment */
+
+	if (pBD->mode == GAP_MODE)
+		return b_insert(pBD, pBD->addc_offset, src, n);
+
+	pBD->flags &= RESET_R_FLAG; /* assume no realloction to start */
+	if (b_fit(pBD, n) == NULL)
+		return NULL;
+
+	/* a contiguous buffer copies everything in the first pass, a segmented one copies up to each segment's end */
+	for (; n > 0; n -= part, src += part) {
+		part = b_run(pBD, pBD->addc_offset);
+		part = n < part ? n : part;
+		memcpy(b_at(pBD, pBD->addc_offset), src, part);
+		pBD->addc_offset += part;
+	}
+	return pBD;
+}
+
+
+/*
+ *	Purpose: Gives a contiguous view of the n chars starting at offset. Only a SEGMENTED_MODE buffer ever
+ *			 needs to copy, when the chars straddle two or more segments, a STREAM_MODE buffer when they
+ *			 wrap around the end of the ring, or a GAP_MODE buffer when they straddle its gap.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.2 STREAM_MODE, GAP_MODE
+ *	Called functions : b_at(), b_run(), b_clear(), b_addn()
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *				 offset: size_t, offset of the first char
+ *				 n: size_t, the number of chars, offset + n must not exceed addc_offset
+ *				 scratch: pBuffer, a contiguous buffer that receives a copy of the chars if they aren't contiguous
+ *						  in pBD, it is cleared first. May be NULL if pBD is neither SEGMENTED_MODE nor STREAM_MODE
+ *						  nor a GAP_MODE buffer edited away from its end (whose gap is inside the chars).
+ *	Return value : NULL on error, a pointer to the first of the n chars otherwise. The pointer is either into
+ *				   pBD (valid until pBD is reallocated) or scratch->cb_head.
+ *	Algorithm : N/A
+ */
+char* b_view(Buffer* const pBD, size_t offset, size_t n, pBuffer const scratch)
+{
+	size_t part; /* # of chars left in the segment holding offset */
+
+	if (pBD == NULL || offset > pBD->addc_offset || n > pBD->addc_offset - offset)
+		return NULL;
+
+	if (n <= b_run(pBD, offset))
+		return b_at(pBD, offset);
+
+	if (scratch == NULL || scratch == pBD || scratch->mode == SEGMENTED_MODE || scratch->mode == STREAM_MODE)
+		return NULL;
+	b_clear(scratch);
+	for (; n > 0; n -= part, offset += part) {
+		part = b_run(pBD, offset);
+		part = n < part ? n : part;
+		if (b_addn(scratch, b_at(pBD, offset), part) == NULL)
+			return NULL;
+	}
+	return scratch->cb_head;
+}
+
+
+/*
+ *	Purpose: Attaches the source a STREAM_MODE buffer pulls its chars from
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : N/A
+ *	Parameters : pBD: A valid pointer to a STREAM_MODE Buffer structure
+ *				 refill: PTR_REFILL, called whenever b_getc() runs out of chars
+ *				 source: void*, passed to refill as is
+ *	Return value : NULL on error, pBD otherwise
+ *	Algorithm : N/A
+ */
+pBuffer b_source(pBuffer const pBD, PTR_REFILL refill, void* source)
+{
+	if (pBD == NULL || pBD->mode != STREAM_MODE || refill == NULL) return NULL;
+
+	pBD->refill = refill;
+	pBD->source = source;
+	return pBD;
 }
 
+
+/*
+ *	Purpose: Inserts n chars starting at src into a GAP_MODE buffer in front of the char at offset.
+ *			 getc_offset and markc_offset stay on the same chars, so they move if they were past offset.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_gapmove(), b_fit(), memcpy()
+ *	Parameters : pBD: A valid pointer to a GAP_MODE Buffer structure
+ *				 offset: size_t, where the first char goes, not more than addc_offset
+ *				 src: const char*, the chars to insert, must not point into the buffer itself
+ *				 n: size_t, the number of chars to insert
+ *	Return value : NULL on error (nothing is inserted), pBD otherwise
+ *	Algorithm : The gap is moved to offset, which only moves the chars between the last edit and this one,
+ *				then the chars are copied into the front of the gap. If the gap is too small the buffer
+ *				grows like a MULTIPLICATIVE_MODE one, b_resize() moves the gap to the end for that.
+ */
+pBuffer b_insert(pBuffer const pBD, size_t offset, const char* src, size_t n)
+{
+	if (pBD == NULL || pBD->mode != GAP_MODE || offset > pBD->addc_offset || (src == NULL && n > 0)) return NULL;
+
+	pBD->flags &= RESET_R_FLAG; /* assume no realloction to start */
+	if (b_fit(pBD, n) == NULL)
+		return NULL;
+
+	b_gapmove(pBD, offset);
+	memcpy(pBD->cb_head + offset, src, n);
+	pBD->addc_offset += n;
+	if (pBD->getc_offset > offset)
+		pBD->getc_offset += n;
+	if (pBD->markc_offset > offset)
+		pBD->markc_offset += n;
+	pBD->flags &= RESET_PAD;
+	return pBD;
+}
+
+
+/*
+ *	Purpose: Removes the n chars starting at offset from a GAP_MODE buffer.
+ *			 getc_offset and markc_offset past the deleted chars move back, inside them they move to offset.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_gapmove()
+ *	Parameters : pBD: A valid pointer to a GAP_MODE Buffer structure
+ *				 offset: size_t, the first char to remove, not more than addc_offset
+ *				 n: size_t, the number of chars to remove, fewer if the buffer ends first
+ *	Return value : NULL on error, pBD otherwise
+ *	Algorithm : The gap is moved to offset and then simply widened over the n chars after it.
+ */
+pBuffer b_delete(pBuffer const pBD, size_t offset, size_t n)
+{
+	if (pBD == NULL || pBD->mode != GAP_MODE || offset > pBD->addc_offset) return NULL;
+
+	if (n > pBD->addc_offset - offset)
+		n = pBD->addc_offset - offset;
+
+	b_gapmove(pBD, offset);
+	pBD->gap_tail -= n;
+	pBD->addc_offset -= n;
+	if (pBD->getc_offset > offset)
+		pBD->getc_offset -= (pBD->getc_offset - offset < n) ? pBD->getc_offset - offset : n;
+	if (pBD->markc_offset > offset)
+		pBD->markc_offset -= (pBD->markc_offset - offset < n) ? pBD->markc_offset - offset : n;
+	pBD->flags &= RESET_PAD;
+	return pBD;
+}
+
+
+/*
+ *	Purpose: Reads the counters a buffer kept since it was allocated, or the totals of all the buffers
+ *			 the calling thread freed so far. The counters are only kept if buffer.c (and any file using the inline cursor)
+ *			 is compiled with B_STATS defined.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : N/A
+ *	Parameters : pBD: A pointer to a Buffer structure, NULL for the totals
+ *				 stats: BufferStats*, receives the counters
+ *	Return value : -1 if stats is NULL or the counters are compiled out, 0 otherwise
+ *	Algorithm : N/A
+ */
+int b_stats(Buffer* const pBD, BufferStats* const stats)
+{
+#ifdef B_STATS
+	if (stats == NULL) return RT_FAIL_1;
+
+	if (pBD == NULL) {
+		*stats = b_totals;
+		return 0;
+	}
+	B_PEAK(pBD);
+	*stats = pBD->stats;
+	return 0;
+#else
+	(void)pBD;
+	if (stats != NULL)
+		memset(stats, 0, sizeof(BufferStats));
+	return RT_FAIL_1;
+#endif
+}
+
+
+/*
+ *	Purpose: Frees the handlers and char buffers b_free() kept for reuse in the calling thread's pool,
+ *			 at the end of the program or before the thread ends
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : free()
+ *	Parameters : N/A
+ *	Return value : N/A
+ *	Algorithm : N/A
+ */
+void b_release(void)
+{
+	pBuffer pBD; /* handler being freed */
+	char* block; /* char buffer being freed */
+	int i; /* size class */
+
+	while ((pBD = b_handles) != NULL) {
+		b_handles = (pBuffer)pBD->source;
+		free(pBD);
+	}
+	b_handle_count = 0;
+	for (i = 0; i < POOL_CLASSES; ++i) {
+		while ((block = b_blocks[i]) != NULL) {
+			b_blocks[i] = *(char**)block;
+			free(block);
+		}
+		b_block_count[i] = 0;
+	}
+}
+
+
+/*
+ *	Purpose: Hands out a new cursor on the chars of pBD without copying them. The first call freezes pBD: it
+ *			 becomes a SHARED_MODE cursor itself, its chars can't change anymore and they are freed with the
+ *			 last cursor. Each cursor has its own getc_offset, markc_offset and flags, so different threads can
+ *			 read the same chars through their own cursors without any locking.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : malloc(), calloc(), free(), b_gapmove()
+ *	Parameters : pBD: A valid pointer to a Buffer structure, contiguous (not SEGMENTED_MODE nor STREAM_MODE).
+ *					  Compact it first so the cursors get the sentinel and its padding as well.
+ *	Return value : NULL on error, the new cursor otherwise, at offset 0. Free it with b_free() when done.
+ *	Algorithm : The chars move into a reference counted BufferShare. A cursor is a handler pointing at them
+ *				like any contiguous buffer, so b_getc() and the inline cursor read it the usual way.
+ *				Cursors are allocated and freed without the pool, so any thread can free one.
+ */
+pBuffer b_share(pBuffer const pBD)
+{
+	struct BufferShare* share; /* the chars, when pBD isn't shared yet */
+	pBuffer cursor; /* the new cursor */
+
+	if (pBD == NULL || pBD->mode == SEGMENTED_MODE || pBD->mode == STREAM_MODE || pBD->cb_head == NULL) return NULL;
+
+	if (pBD->mode != SHARED_MODE) {
+		if (!(share = (struct BufferShare*)malloc(sizeof(struct BufferShare))))
+			return NULL;
+		if (pBD->mode == GAP_MODE)
+			b_gapmove(pBD, pBD->addc_offset);
+		share->refs = 1;
+		share->head = pBD->cb_head;
+		share->mapped = 0;
+#ifndef _WIN32
+		if (pBD->mode == READONLY_MODE)
+			share->mapped = pBD->capacity + SENTINEL_PAD;
+#endif
+		pBD->share = share;
+		pBD->mode = SHARED_MODE;
+		pBD->inc_factor = 0;
+		pBD->flags &= RESET_POOL; /* freed with free() by the last cursor */
+	}
+
+	if (!(cursor = (Buffer*)calloc(1, sizeof(Buffer))))
+		return NULL;
+	B_ADDREF(pBD->share);
+	cursor->cb_head = pBD->cb_head;
+	cursor->capacity = pBD->capacity;
+	cursor->addc_offset = pBD->addc_offset;
+	cursor->mode = SHARED_MODE;
+	cursor->share = pBD->share;
+	cursor->flags = DEFAULT_FLAGS | (pBD->flags & CHECK_PAD);
+	return cursor;
+}
+
+
+/* Grows a full ADDITIVE_MODE buffer by inc_factor bytes, without looking at its mode, for b_addc_as().
+   Returns NULL if it can't grow, pBD otherwise */
+pBuffer b_grow_add(pBuffer const pBD) {
+	pBD->flags &= RESET_R_FLAG; /* assume no realloction to start */
+	return b_realloc(pBD, b_next(pBD->capacity, (unsigned char)pBD->inc_factor));
+}
+
+
+/* Grows a full MULTIPLICATIVE_MODE buffer by inc_factor percent, without looking at its mode, for b_addc_as().
+   Returns NULL if it can't grow, pBD otherwise */
+pBuffer b_grow_mul(pBuffer const pBD) {
+	pBD->flags &= RESET_R_FLAG; /* assume no realloction to start */
+	return b_realloc(pBD, b_next(pBD->capacity, b_mulinc(pBD->capacity, pBD->inc_factor)));
+}
+
+
+/*
+ *	Purpose: Maps the file behind fi into memory as the char buffer of a READONLY_MODE buffer.
+ *			 One byte past the end of the file is always addressable and writable so b_compact() can
+ *			 append the SEOF sentinel without copying the file, and SENTINEL_PAD zeroed bytes follow it.
+ *			 The file itself is never written to.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : fstat(), mmap(), munmap(), madvise(), sysconf() (_fstat64(), malloc(), fread() on Windows)
+ *	Parameters : fi: A valid pointer to a FILE struct opened on a regular file
+ *				 pBD: A valid pointer to a READONLY_MODE Buffer structure which has not been loaded yet
+ *	Return value : RT_FAIL_1 on error, the size of the file otherwise
+ *	Algorithm : Reserve an anonymous private region 1 + SENTINEL_PAD bytes bigger than the file, then map the file over
+ *				the front of it. The sentinel byte lands either in the zero-filled tail of the file's last
+ *				page or in the anonymous page after it. Both are copy-on-write.
+ *				The file is read front to back, so the kernel is told to read ahead in the background
+ *				while the scanner works on the pages already in memory.
+ */
+static size_t b_map(FILE* const fi, Buffer* const pBD)
+{
+	size_t size; /* size of the file in bytes */
+
+	if (pBD->cb_head != NULL)  return RT_FAIL_1;
+
+#ifdef _WIN32
+	/* no portable way to reserve memory past a view of a file on Windows, read the file in one block instead */
+	struct _stat64 st; /* file status, for the size */
+	if (_fstat64(_fileno(fi), &st) != 0 || (st.st_mode & _S_IFREG) == 0 || (unsigned long long)st.st_size >= MAX_BUF_CAPACITY)
+		return RT_FAIL_1;
+	size = (size_t)st.st_size;
+	if (!(pBD->cb_head = (char*)calloc(size + 1 + SENTINEL_PAD, 1)))
+		return RT_FAIL_1;
+	/* text mode translation can only shrink the file */
+	size = fread(pBD->cb_head, 1, size, fi);
+#else
+	struct stat st; /* file status, for the size */
+	size_t page = (size_t)sysconf(_SC_PAGESIZE); /* mapping granularity */
+	size_t map_len; /* size of the whole mapping, file + sentinel rounded up to the page size */
+	void* base; /* starting address of the mapping */
+
+	if (fstat(fileno(fi), &st) != 0 || !S_ISREG(st.st_mode) || (unsigned long long)st.st_size >= MAX_BUF_CAPACITY)
+		return RT_FAIL_1;
+	size = (size_t)st.st_size;
+	map_len = (size + 1 + SENTINEL_PAD + page - 1) / page * page;
+
+	if ((base = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+		return RT_FAIL_1;
+	if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fileno(fi), 0) == MAP_FAILED) {
+		munmap(base, map_len);
+		return RT_FAIL_1;
+	}
+#ifdef MADV_SEQUENTIAL
+	if (size > 0)
+		madvise(base, size, MADV_SEQUENTIAL);
+#endif
+	pBD->cb_head = (char*)base;
+#endif
+
+	pBD->capacity = size + 1;
+	pBD->addc_offset = size;
+	pBD->getc_offset = pBD->markc_offset = 0;
+	return size;
+}
+
+
+/*
+ *	Purpose: Computes the capacity the buffer grows to the next time it fills up, according to its mode
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : N/A
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *	Return value : 0 if the buffer can't grow, the new capacity otherwise
+ *	Algorithm : ADDITIVE_MODE adds inc_factor bytes. MULTIPLICATIVE_MODE adds inc_factor percent of the
+ *				current capacity (at least one byte), see b_mulinc(). The sum is clamped to MAX_BUF_CAPACITY.
+ */
+static size_t b_growth(Buffer* const pBD)
+{
+	switch (pBD->mode) {
+	case ADDITIVE_MODE:	return b_next(pBD->capacity, (unsigned char)pBD->inc_factor);
+
+	case MULTIPLICATIVE_MODE:
+	case GAP_MODE:	/* grows like MULTIPLICATIVE_MODE, the increment is a percentage */
+		return b_next(pBD->capacity, b_mulinc(pBD->capacity, pBD->inc_factor));
+
+		/* catches FIXED_MODE, READONLY_MODE and SHARED_MODE */
+	default:  return 0;
+	}
+}
+
+
+/* Adds increment to capacity, clamped to MAX_BUF_CAPACITY. Returns 0 if capacity is already maxed out */
+static size_t b_next(size_t capacity, size_t increment) {
+	if (capacity >= MAX_BUF_CAPACITY)
+		return 0;
+	return (increment > MAX_BUF_CAPACITY - capacity) ? MAX_BUF_CAPACITY : capacity + increment;
+}
+
+
+/* Computes inc_factor percent of capacity, at least one byte, dividing first so the multiplication can't overflow */
+static size_t b_mulinc(size_t capacity, char inc_factor) {
+	size_t increment = capacity / 100 * (unsigned char)inc_factor + capacity % 100 * (unsigned char)inc_factor / 100; /* the bytes */
+	return increment ? increment : 1;
+}
+
+
+/*
+ *	Purpose: Reallocates the char buffer to new_capacity bytes with b_realloc().
+ *			 The gap of a GAP_MODE buffer is moved to the end first, the chars after it would be cut off otherwise.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.2 GAP_MODE, the reallocation moved to b_realloc()
+ *	Called functions : b_gapmove(), b_realloc()
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *				 new_capacity: size_t, the new size of the char buffer, must not be less than addc_offset
+ *	Return value : NULL on error (the buffer is left untouched), pBD otherwise
+ *	Algorithm : N/A
+ */
+static pBuffer b_resize(Buffer* const pBD, size_t new_capacity)
+{
+	if (new_capacity == 0 || new_capacity < pBD->addc_offset)
+		return NULL;
+	if (pBD->mode == GAP_MODE)
+		b_gapmove(pBD, pBD->addc_offset);
+	return b_realloc(pBD, new_capacity);
+}
+
+
+/*
+ *	Purpose: Reallocates the contiguous char buffer of any mode but GAP_MODE to new_capacity bytes and sets
+ *			 the r_flag if it moved. A pooled char buffer stops being one, it may not have a pooled size anymore.
+ *			 It doesn't look at the mode, b_grow_add() and b_grow_mul() call it directly.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : realloc()
+ *	Parameters : pBD: A valid pointer to a Buffer structure, not GAP_MODE
+ *				 new_capacity: size_t, the new size of the char buffer, must not be less than addc_offset
+ *	Return value : NULL on error (the buffer is left untouched), pBD otherwise
+ *	Algorithm : N/A
+ */
+static pBuffer b_realloc(Buffer* const pBD, size_t new_capacity)
+{
+	/* realloc_ptr will store the return value of realloc() to avoid a potential dangling pointer
+		it is also used to check if the block of memory was moved so we can set the r_flag accordingly */
+	void* realloc_ptr;
+
+	if (new_capacity == 0 || new_capacity < pBD->addc_offset)
+		return NULL;
+	if (new_capacity == pBD->capacity)
+		return pBD;
+
+	B_PEAK(pBD); /* before a b_compact() shrinks it */
+	if (!(realloc_ptr = realloc(pBD->cb_head, new_capacity)))
+		return NULL;
+	pBD->flags &= RESET_PAD; /* the padding is either gone or past the chars about to be added */
+	pBD->flags &= RESET_POOL; /* no longer one of the pool's sizes */
+	B_COUNT(pBD, grows, 1);
+
+	/* check if the starting address was moved, if so, set R_FLAG and assign cb_head the new starting address */
+	if (pBD->cb_head != (char*)realloc_ptr) {
+		B_COUNT(pBD, moves, 1);
+		B_COUNT(pBD, copied, (new_capacity < pBD->capacity) ? new_capacity : pBD->capacity);
+		pBD->flags |= SET_R_FLAG;
+		pBD->cb_head = (char*)realloc_ptr;
+	}
+	pBD->capacity = new_capacity;
+	return pBD;
+}
+
+
+/*
+ *	Purpose: Finds the number of bytes left to read in the file behind fi
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : fstat(), ftell() (_fstat64() on Windows)
+ *	Parameters : fi: A valid pointer to a FILE struct
+ *	Return value : 0 if unknown (not a regular file), the number of bytes between the file position and the end otherwise
+ *	Algorithm : N/A
+ */
+static size_t b_filesize(FILE* const fi)
+{
+	long pos = ftell(fi); /* current file position, -1 on a pipe */
+#ifdef _WIN32
+	struct _stat64 st; /* file status, for the size */
+	if (pos < 0 || _fstat64(_fileno(fi), &st) != 0 || (st.st_mode & _S_IFREG) == 0)
+		return 0;
+#else
+	struct stat st; /* file status, for the size */
+	if (pos < 0 || fstat(fileno(fi), &st) != 0 || !S_ISREG(st.st_mode))
+		return 0;
+#endif
+	/* text mode translation on Windows can only make the file shorter, so this is an upper bound */
+	return ((unsigned long long)st.st_size > (unsigned long long)pos) ? (size_t)(st.st_size - pos) : 0;
+}
+
+
+/*
+ *	Purpose: Grows the buffer, if needed, so n more chars fit
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_growth(), b_resize()
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *				 n: size_t, the number of chars about to be added
+ *	Return value : NULL if the buffer can't hold n more chars, pBD otherwise
+ *	Algorithm : The new capacity is the larger of the mode's next capacity and the capacity actually needed.
+ *				A multiplicative buffer therefore still grows geometrically when chars are added in bulk,
+ *				which keeps appends amortized O(1).
+ */
+static pBuffer b_fit(Buffer* const pBD, size_t n)
+{
+	size_t new_capacity; /* capacity after growing the buffer */
+
+	if (n <= pBD->capacity - pBD->addc_offset)
+		return pBD;
+	if (n > MAX_BUF_CAPACITY - pBD->addc_offset)
+		return NULL;
+
+	/* segmented buffers add whole segments, nothing already in the buffer moves */
+	if (pBD->mode == SEGMENTED_MODE) {
+		while (n > pBD->capacity - pBD->addc_offset)
+			if (b_addseg(pBD) == NULL)
+				return NULL;
+		return pBD;
+	}
+
+	if ((new_capacity = b_growth(pBD)) == 0)
+		return NULL;
+
+	return b_resize(pBD, new_capacity > pBD->addc_offset + n ? new_capacity : pBD->addc_offset + n);
+}
+
+
+/*
+ *	Purpose: Appends one segment to a SEGMENTED_MODE buffer
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : malloc(), realloc()
+ *	Parameters : pBD: A valid pointer to a SEGMENTED_MODE Buffer structure
+ *	Return value : NULL on error, pBD otherwise
+ *	Algorithm : The array of segment pointers doubles whenever seg_count reaches a power of two, so it
+ *				never needs a separate slot count. Only that array of pointers is ever reallocated.
+ */
+static pBuffer b_addseg(Buffer* const pBD)
+{
+	char** segs; /* segment pointer array, possibly moved */
+	char* seg;	 /* the new segment */
+
+	if (pBD->capacity > MAX_BUF_CAPACITY - SEGMENT_SIZE)
+		return NULL;
+
+	if ((pBD->seg_count & (pBD->seg_count - 1)) == 0) {
+		if (!(segs = (char**)realloc(pBD->segs, (pBD->seg_count ? pBD->seg_count * 2 : 1) * sizeof(char*))))
+			return NULL;
+		pBD->segs = segs;
+	}
+	if (!(seg = (char*)malloc(SEGMENT_SIZE)))
+		return NULL;
+
+	pBD->segs[pBD->seg_count++] = seg;
+	pBD->capacity += SEGMENT_SIZE;
+	B_COUNT(pBD, grows, 1);
+	return pBD;
+}
+
+
+/*
+ *	Purpose: Finds the address of the char at offset
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.1 GAP_MODE
+ *	Called functions : N/A
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *				 offset: size_t, less than capacity (or equal to it outside SEGMENTED_MODE), any offset in STREAM_MODE,
+ *						 not more than addc_offset in GAP_MODE (addc_offset itself only while the gap is at the end)
+ *	Return value : the address of the char
+ *	Algorithm : N/A
+ */
+static char* b_at(Buffer* const pBD, size_t offset)
+{
+	if (pBD->mode == SEGMENTED_MODE)
+		return (offset == pBD->capacity) ? NULL : pBD->segs[offset >> SEGMENT_SHIFT] + (offset & SEGMENT_MASK);
+	if (pBD->mode == STREAM_MODE)
+		return pBD->cb_head + (offset & (pBD->capacity - 1));
+	if (pBD->mode == GAP_MODE && pBD->gap_tail > 0 && offset >= pBD->addc_offset - pBD->gap_tail)
+		return pBD->cb_head + offset + (pBD->capacity - pBD->addc_offset); /* skip the gap */
+	return pBD->cb_head + offset; /* pointer arithmetic, no dereferencing */
+}
+
+
+/*
+ *	Purpose: Finds how many chars starting at offset are contiguous in memory
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : N/A
+ *	Parameters : pBD: A valid pointer to a Buffer structure
+ *				 offset: size_t, an offset into the buffer
+ *	Return value : the number of chars up to the end of the segment, ring or gap, MAX_BUF_CAPACITY for a contiguous buffer
+ *	Algorithm : N/A
+ */
+static size_t b_run(Buffer* const pBD, size_t offset)
+{
+	if (pBD->mode == SEGMENTED_MODE)
+		return SEGMENT_SIZE - (offset & SEGMENT_MASK);
+	if (pBD->mode == STREAM_MODE)
+		return pBD->capacity - (offset & (pBD->capacity - 1));
+	if (pBD->mode == GAP_MODE && pBD->gap_tail > 0 && offset < pBD->addc_offset - pBD->gap_tail)
+		return pBD->addc_offset - pBD->gap_tail - offset;
+	return MAX_BUF_CAPACITY;
+}
+
+
+/*
+ *	Purpose: Pulls more chars from the source of a STREAM_MODE buffer into its ring
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : malloc(), free(), memcpy(), b_run(), the refill callback
+ *	Parameters : pBD: A valid pointer to a STREAM_MODE Buffer structure
+ *	Return value : the number of chars added to the buffer, 0 at the end of the source or on error
+ *	Algorithm : The chars from min(markc_offset, getc_offset - 1) up to addc_offset are still in use: the
+ *				scanner retracts to its mark or by one char. Everything before that may be overwritten.
+ *				If the chars in use fill the whole ring, the ring doubles, so its size is bounded by the
+ *				longest lexeme rather than the size of the source. The refill callback then reads into the
+ *				free space up to the end of the ring. When it returns 0 the symbol b_compact() asked for is
+ *				appended, once.
+ */
+static size_t b_fill(Buffer* const pBD)
+{
+	size_t keep = pBD->getc_offset > 0 ? pBD->getc_offset - 1 : 0; /* offset of the oldest char still in use */
+	size_t room; /* free space after addc_offset, up to the end of the ring */
+	size_t part; /* chars copied at once when the ring grows */
+	size_t offset; /* offset of the next char to copy when the ring grows */
+	char* ring;	 /* the grown ring */
+
+	if (pBD->refill == NULL && pBD->eos < 0)
+		return 0;
+	if (pBD->markc_offset < keep)
+		keep = pBD->markc_offset;
+
+	/* every char in the ring is still in use, double it */
+	if (pBD->addc_offset - keep >= pBD->capacity) {
+		if (pBD->capacity > MAX_BUF_CAPACITY / 2 || !(ring = (char*)malloc(pBD->capacity * 2)))
+			return 0;
+		for (offset = keep; offset < pBD->addc_offset; offset += part) {
+			part = b_run(pBD, offset);
+			part = (part < pBD->addc_offset - offset) ? part : pBD->addc_offset - offset;
+			if (part > pBD->capacity * 2 - (offset & (pBD->capacity * 2 - 1)))
+				part = pBD->capacity * 2 - (offset & (pBD->capacity * 2 - 1));
+			memcpy(ring + (offset & (pBD->capacity * 2 - 1)), b_at(pBD, offset), part);
+		}
+		free(pBD->cb_head);
+		pBD->cb_head = ring;
+		B_COUNT(pBD, grows, 1);
+		B_COUNT(pBD, moves, 1);
+		B_COUNT(pBD, copied, pBD->addc_offset - keep);
+		pBD->capacity *= 2;
+		pBD->flags |= SET_R_FLAG;
+	}
+
+	room = pBD->capacity - (pBD->addc_offset - keep);
+	if (room > b_run(pBD, pBD->addc_offset))
+		room = b_run(pBD, pBD->addc_offset);
+
+	if (pBD->refill != NULL && (room = pBD->refill(pBD->source, b_at(pBD, pBD->addc_offset), room)) > 0) {
+		pBD->addc_offset += room;
+		return room;
+	}
+
+	/* the source is exhausted, don't call it again */
+	pBD->refill = NULL;
+	if (pBD->eos < 0)
+		return 0;
+	*b_at(pBD, pBD->addc_offset++) = (char)pBD->eos;
+	pBD->eos = -1;
+	return 1;
+}
+
+
+/*
+ *	Purpose: Refill callback for STREAM_MODE buffers reading from a FILE, used by b_load()
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : fread()
+ *	Parameters : source: void*, the FILE to read from
+ *				 dst: char*, where to put the chars
+ *				 n: size_t, maximum number of chars to read
+ *	Return value : the number of chars read, 0 at the end of the file
+ *	Algorithm : N/A
+ */
+static size_t b_fread(void* source, char* dst, size_t n)
+{
+	return fread(dst, 1, n, (FILE*)source);
+}
+
+
+/*
+ *	Purpose: Moves the gap of a GAP_MODE buffer so it starts at offset
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : memmove()
+ *	Parameters : pBD: A valid pointer to a GAP_MODE Buffer structure
+ *				 offset: size_t, not more than addc_offset. addc_offset moves the gap to the end.
+ *	Return value : N/A
+ *	Algorithm : The gap is all of the free space, capacity - addc_offset bytes. Only the chars between
+ *				the old and the new position of the gap move, to the other side of it.
+ */
+static void b_gapmove(Buffer* const pBD, size_t offset)
+{
+	size_t gap = pBD->addc_offset - pBD->gap_tail; /* offset of the gap now */
+	size_t size = pBD->capacity - pBD->addc_offset; /* size of the gap in bytes */
+
+	if (offset < gap)
+		memmove(pBD->cb_head + offset + size, pBD->cb_head + offset, gap - offset);
+	else if (offset > gap)
+		memmove(pBD->cb_head + gap, pBD->cb_head + gap + size, offset - gap);
+	pBD->gap_tail = pBD->addc_offset - offset;
+}
+
+
+/*
+ *	Purpose: Takes a zeroed handler from the pool, or allocates one
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : memset(), calloc()
+ *	Parameters : N/A
+ *	Return value : NULL on error, the handler otherwise
+ *	Algorithm : N/A
+ */
+static pBuffer b_takehandle(void)
+{
+	pBuffer pBD = b_handles; /* the handler taken */
+
+	if (pBD == NULL)
+		return (Buffer*)calloc(1, sizeof(Buffer));
+	b_handles = (pBuffer)pBD->source;
+	--b_handle_count;
+	memset(pBD, 0, sizeof(Buffer));
+	return pBD;
+}
+
+
+/*
+ *	Purpose: Takes a char buffer of at least size bytes from the pool, or allocates one
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : malloc()
+ *	Parameters : pBD: A valid pointer to the Buffer structure the char buffer is for
+ *				 size: size_t, the number of bytes needed
+ *	Return value : NULL on error, the char buffer otherwise
+ *	Algorithm : Sizes up to the biggest class are rounded up to a power of two (at least 1 << POOL_MIN_SHIFT,
+ *				which also holds the link of a free block) and the flag SET_POOL tells b_free() so. Bigger
+ *				sizes are allocated as is.
+ */
+static char* b_takeblock(Buffer* const pBD, size_t size)
+{
+	char* block; /* the char buffer taken */
+	int i; /* size class */
+
+	for (i = 0; i < POOL_CLASSES && ((size_t)1 << (i + POOL_MIN_SHIFT)) < size; ++i)
+		;
+	if (i == POOL_CLASSES) {
+		pBD->flags &= RESET_POOL;
+		return (char*)malloc(size);
+	}
+
+	if ((block = b_blocks[i]) != NULL) {
+		b_blocks[i] = *(char**)block;
+		--b_block_count[i];
+	}
+	else if (!(block = (char*)malloc((size_t)1 << (i + POOL_MIN_SHIFT))))
+		return NULL;
+	pBD->flags |= SET_POOL;
+	return block;
+}
+
+
+/*
+ *	Purpose: Gives the char buffer of pBD back to the pool if it is a pooled one with room left, frees it otherwise
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : free()
+ *	Parameters : pBD: A valid pointer to a Buffer structure, its char buffer is gone afterwards
+ *	Return value : N/A
+ *	Algorithm : The size class is found again from the capacity, which never changes without b_resize()
+ *				clearing the pool flag.
+ */
+static void b_dropblock(Buffer* const pBD)
+{
+	int i; /* size class */
+
+	if (pBD->cb_head != NULL && (pBD->flags & CHECK_POOL)) {
+		for (i = 0; i < POOL_CLASSES && ((size_t)1 << (i + POOL_MIN_SHIFT)) < pBD->capacity; ++i)
+			;
+		if (b_block_count[i] < POOL_DEPTH) {
+			*(char**)pBD->cb_head = b_blocks[i];
+			b_blocks[i] = pBD->cb_head;
+			++b_block_count[i];
+			pBD->cb_head = NULL;
+			return;
+		}
+	}
+	free(pBD->cb_head);
+	pBD->cb_head = NULL;
+}
@@ -22,6 +22,8 @@
 #include <stdio.h>  /* standard input/output */
 #include <malloc.h> /* for dynamic memory allocation*/
 #include <limits.h> /* implementation-defined data type ranges and limits */
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* SIZE_MAX, PTRDIFF_MAX */
 
 /* constant definitions */
 #define RT_FAIL_1 (-1)         /* operation failure return value 1 */
@@ -35,57 +37,163 @@
 #define ADDITIVE_MODE 1
 #define MULTIPLICATIVE_MODE (-1)
 #define FIXED_MODE 0
-#define MAX_BUF_CAPACITY (SHRT_MAX-1)
+#define READONLY_MODE 2 /* source file mapped into memory by b_load(), no b_addc() */
+#define SEGMENTED_MODE 3 /* list of fixed-size segments, growing never copies the chars already added */
+#define STREAM_MODE 4 /* ring of chars refilled on demand from a source, only chars still in use are kept */
+#define GAP_MODE 5 /* free space kept as a gap at the last edit, b_insert() and b_delete() only move the chars in between */
+#define SHARED_MODE 6 /* read-only cursor made by b_share(), the chars are shared with the other cursors and freed with the last one */
+
+#define SEGMENT_SHIFT 16						/* log2 of the segment size */
+#define SEGMENT_SIZE ((size_t)1 << SEGMENT_SHIFT)	/* bytes per segment in SEGMENTED_MODE */
+#define SEGMENT_MASK (SEGMENT_SIZE - 1)			/* offset & SEGMENT_MASK is the position inside a segment */
+#define MAX_BUF_CAPACITY ((size_t)PTRDIFF_MAX) /* largest addressable object -- never collides with (size_t)RT_FAIL_1 */
+#define SENTINEL_PAD 64 /* zeroed bytes b_compact() leaves after the sentinel, covers the widest vector load */
+
+#define POOL_MIN_SHIFT 4 /* log2 of the smallest pooled char buffer */
+#define POOL_CLASSES 9	 /* pooled char buffers are 16, 32, ... 4096 bytes, bigger ones go straight to malloc() */
+#define POOL_DEPTH 32	 /* most handlers and char buffers of each size b_free() keeps for reuse */
 
 #ifdef B_FULL
 #define b_isfull(pBD) ((pBD == NULL) ? (RT_FAIL_1) : (pBD->addc_offset == pBD->capacity))
 #endif
 
+/* Instrumentation. Defining B_STATS for the whole build (compiler option) makes every buffer count its growth
+   and reads in its stats member, see b_stats(). Without it the counting compiles to nothing. */
+#ifdef B_STATS
+#define B_COUNT(pBD, counter, n) ((pBD)->stats.counter += (n))
+#define B_PEAK(pBD) ((pBD)->stats.peak = ((pBD)->capacity > (pBD)->stats.peak) ? (pBD)->capacity : (pBD)->stats.peak)
+#else
+#define B_COUNT(pBD, counter, n) ((void)0)
+#define B_PEAK(pBD) ((void)0)
+#endif
+
+/* Inline cursor. A buffer compacted by b_compact() is contiguous and ends in the sentinel followed by
+   SENTINEL_PAD zeroed bytes (SEOB), so a scanner stops on the sentinel without any end-of-buffer check.
+   If the including file defines B_CURSOR, these calls expand inline for such buffers and still go through
+   the functions for the others. The inline b_getc() doesn't maintain the EOB flag, b_mark() keeps the bounds
+   check of the function, and the arguments are evaluated more than once. */
+#ifdef B_CURSOR
+#define b_padded(pBD) ((pBD)->flags & CHECK_PAD)
+#define b_getc(pBD) (b_padded(pBD) ? (B_COUNT(pBD, getcs, 1), (pBD)->cb_head[(pBD)->getc_offset++]) : (b_getc)(pBD))
+#define b_retract(pBD) (b_padded(pBD) ? (B_COUNT(pBD, retracts, 1), --(pBD)->getc_offset) : (b_retract)(pBD))
+#define b_getcoffset(pBD) (b_padded(pBD) ? (pBD)->getc_offset : (b_getcoffset)(pBD))
+#define b_mark(pBD, mark) (b_padded(pBD) && (mark) <= (pBD)->addc_offset ? ((pBD)->markc_offset = (mark)) : (b_mark)(pBD, mark))
+#define b_reset(pBD) (b_padded(pBD) ? ((pBD)->getc_offset = (pBD)->markc_offset) : (b_reset)(pBD))
+#endif
+
+/* Compile-time growth policy. A caller that knows a buffer's mode statically allocates it with b_allocate_as()
+   and appends to it with b_addc_as() (defined after the declarations), passing the same constant mode
+   (ADDITIVE_MODE, MULTIPLICATIVE_MODE or FIXED_MODE). b_addc_as() never reads the buffer's mode: it inlines
+   to a capacity test and a store, and the constant picks b_grow_add(), b_grow_mul() or no growth at all when
+   the buffer is full. The allocation macro only maps the constant to the o_mode char, the allocation still
+   goes through b_allocate(). */
+#define b_allocate_as(init_capacity, inc_factor, mode) \
+	b_allocate(init_capacity, inc_factor, (mode) == FIXED_MODE ? 'f' : (mode) == ADDITIVE_MODE ? 'a' : 'm')
+
+/* inline functions of this header, MS Visual Studio's C compiler spells inline __inline */
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define B_INLINE static __inline
+#else
+#define B_INLINE static inline
+#endif
+
 /* Add your bit-masks constant definitions here */
-#define DEFAULT_FLAGS  0xFFFC
+#define DEFAULT_FLAGS  0xFFF0
 #define SET_EOB 0x0002 /* operand 1 | SET_EOB will preserve operand 1 bits but will set the 2nd LSB to be 1 */
 #define RESET_EOB  0xFFFD /* operand 1 & RESET_EOB will preserve operand 1 bits but will set the 2nd LSB to be 0 */
 #define CHECK_EOB  0x0002 /* checks the 2nd LSB bit against 1 */
 #define SET_R_FLAG 0x0001 /* operand 1 | SET_R_FLAG will preserve operand 1 bits but set the LSB to be 1 */
 #define RESET_R_FLAG 0xFFFE /* operand 1 & RESET_R_FLAG will preserve operand 1 bits but will set the LSB to be 0 */
 #define CHECK_R_FLAG  0x0001 /* checks the LSB against 1 */
+#define SET_PAD 0x0004 /* operand 1 | SET_PAD will preserve operand 1 bits but set the 3rd LSB to be 1 */
+#define RESET_PAD 0xFFFB /* operand 1 & RESET_PAD will preserve operand 1 bits but set the 3rd LSB to be 0 */
+#define CHECK_PAD 0x0004 /* checks the 3rd LSB against 1 -- set while the buffer ends in the sentinel and its padding */
+#define SET_POOL 0x0008 /* operand 1 | SET_POOL will preserve operand 1 bits but set the 4th LSB to be 1 */
+#define RESET_POOL 0xFFF7 /* operand 1 & RESET_POOL will preserve operand 1 bits but set the 4th LSB to be 0 */
+#define CHECK_POOL 0x0008 /* checks the 4th LSB against 1 -- set while the char buffer is a whole pooled block */
 
 /* user data type declarations */
+
+/* refill callback of a STREAM_MODE buffer: reads at most n chars from source into dst, returns the number read, 0 at the end */
+typedef size_t (*PTR_REFILL)(void* source, char* dst, size_t n);
+
+/* counters kept by a buffer when B_STATS is defined, all 0 otherwise */
+typedef struct BufferStats {
+	size_t grows;    /* times the char buffer was reallocated, a segment added or the ring doubled */
+	size_t moves;    /* times the char buffer moved to a new address (r_flag set) */
+	size_t copied;   /* bytes copied by those moves */
+	size_t peak;     /* largest capacity the buffer reached */
+	size_t getcs;    /* b_getc() calls */
+	size_t retracts; /* b_retract() calls */
+} BufferStats;
+
 typedef struct BufferDescriptor {
-	char* cb_head;   /* pointer to the beginning of character array (character buffer) */
-	short capacity;    /* current dynamic memory size (in bytes) allocated to character buffer */
-	short addc_offset;  /* the offset (in chars) to the add-character location */
-	short getc_offset;  /* the offset (in chars) to the get-character location */
-	short markc_offset; /* the offset (in chars) to the mark location */
+	char* cb_head;   /* pointer to the beginning of character array (character buffer), NULL in SEGMENTED_MODE */
+	char** segs;     /* SEGMENTED_MODE: array of pointers to segments, offset >> SEGMENT_SHIFT indexes it */
+	size_t seg_count; /* SEGMENTED_MODE: number of segments allocated */
+	PTR_REFILL refill; /* STREAM_MODE: pulls more chars into the ring, NULL once the source is exhausted */
+	void* source;     /* STREAM_MODE: argument passed to refill. Next free handler while the handler is pooled */
+	int eos;          /* STREAM_MODE: symbol b_compact() appends when the source is exhausted, -1 if none */
+	size_t gap_tail;  /* GAP_MODE: number of chars after the gap, 0 when the gap is at the end (the free space of any buffer) */
+	struct BufferShare* share; /* SHARED_MODE: the chars and the number of cursors reading them, defined in buffer.c */
+	size_t capacity;    /* current dynamic memory size (in bytes) allocated to character buffer */
+	size_t addc_offset;  /* the offset (in chars) to the add-character location */
+	size_t getc_offset;  /* the offset (in chars) to the get-character location */
+	size_t markc_offset; /* the offset (in chars) to the mark location */
 	char  inc_factor; /* character array increment factor */
 	char  mode;       /* operational mode indicator*/
 	unsigned short flags;     /* contains character array reallocation flag and end-of-buffer flag */
+	BufferStats stats; /* always present so the layout doesn't depend on B_STATS */
 } Buffer, * pBuffer;
 
 
 /* function declarations */
-Buffer* b_allocate(short init_capacity, char inc_factor, char o_mode);
+Buffer* b_allocate(size_t init_capacity, char inc_factor, char o_mode);
 pBuffer b_addc(pBuffer const pBD, char symbol);
 int b_clear(Buffer* const pBD);
 void b_free(Buffer* const pBD);
 int (b_isfull)(Buffer* const pBD); /* necessary to wrap b_isfull with parenthesis to avoid name collision with the macro of the same name */
-short b_limit(Buffer* const pBD);
-short b_capacity(Buffer* const pBD);
-short b_mark(pBuffer const pBD, short mark);
+size_t b_limit(Buffer* const pBD);
+size_t b_capacity(Buffer* const pBD);
+size_t (b_mark)(pBuffer const pBD, size_t mark); /* parenthesis for the inline cursor macros, see b_isfull */
 int b_mode(Buffer* const pBD);
 size_t b_incfactor(Buffer* const pBD);
-int b_load(FILE* const fi, Buffer* const pBD);
+size_t b_load(FILE* const fi, Buffer* const pBD);
 int b_isempty(Buffer* const pBD);
-char b_getc(Buffer* const pBD);
+char (b_getc)(Buffer* const pBD);
 int b_eob(Buffer* const pBD);
-int b_print(Buffer* const pBD, char nl);
+size_t b_print(Buffer* const pBD, char nl);
 Buffer* b_compact(Buffer* const pBD, char symbol);
 char b_rflag(Buffer* const pBD);
-short b_retract(Buffer* const pBD);
-short b_reset(Buffer* const pBD);
-short b_getcoffset(Buffer* const pBD);
+size_t (b_retract)(Buffer* const pBD);
+size_t (b_reset)(Buffer* const pBD);
+size_t (b_getcoffset)(Buffer* const pBD);
 int b_rewind(Buffer* const pBD);
 char* b_location(Buffer* const pBD);
+pBuffer b_reserve(pBuffer const pBD, size_t n);
+pBuffer b_addn(pBuffer const pBD, const char* src, size_t n);
+char* b_view(Buffer* const pBD, size_t offset, size_t n, pBuffer const scratch);
+pBuffer b_source(pBuffer const pBD, PTR_REFILL refill, void* source);
+pBuffer b_insert(pBuffer const pBD, size_t offset, const char* src, size_t n);
+pBuffer b_delete(pBuffer const pBD, size_t offset, size_t n);
+int b_stats(Buffer* const pBD, BufferStats* const stats);
+void b_release(void);
+pBuffer b_share(pBuffer const pBD);
+pBuffer b_grow_add(pBuffer const pBD);
+pBuffer b_grow_mul(pBuffer const pBD);
+
+/* Appends symbol to a buffer allocated by b_allocate_as() with the same constant mode, any other buffer must
+   go through b_addc(). Returns pBD, or NULL if pBD is NULL or the buffer can't grow, as b_addc() does */
+B_INLINE pBuffer b_addc_as(pBuffer const pBD, char symbol, int mode) {
+	if (pBD == NULL)
+		return NULL;
+	if (pBD->addc_offset < pBD->capacity)
+		pBD->flags &= RESET_R_FLAG;
+	else if (mode == FIXED_MODE || (mode == ADDITIVE_MODE ? b_grow_add(pBD) : b_grow_mul(pBD)) == NULL)
+		return NULL;
+	pBD->cb_head[pBD->addc_offset++] = symbol;
+	return pBD;
+}
 
 #endif
 
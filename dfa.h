@@ -0,0 +1,103 @@
+/*	File name:	dfa.h
+ *	Purpose:	The DFA of table.h coded directly, included by malar_next_token_ctx() with DFA_DIRECT.
+ *				Generated by dfagen from st_table, as_table and cc_table - DO NOT EDIT, run "make dfa.h".
+ */
+
+/* state 0 */
+	col = cc_table[(unsigned char)c];
+	switch (col) {
+	case 0:	/* [a-zA-Z] */
+		goto dfa_s1;
+	case 1:	/* 0 */
+		goto dfa_s6;
+	case 2:	/* [1-9] */
+		goto dfa_s4;
+	case 5:	/* " */
+		goto dfa_s9;
+	default:
+		state = 11;
+		goto dfa_accept;
+	}
+
+/* state 1, stays on [a-zA-Z] 0 [1-9] */
+dfa_s1:
+	do {
+		DFA_ENTER(1);
+		DFA_GETC();
+		col = cc_table[(unsigned char)c];
+	} while (0x07u >> col & 1);
+	switch (col) {
+	case 4:	/* @ */
+		state = 3;
+		goto dfa_accept;
+	default:
+		state = 2;
+		goto dfa_accept;
+	}
+
+/* state 4, stays on 0 [1-9] */
+dfa_s4:
+	do {
+		DFA_ENTER(4);
+		DFA_GETC();
+		col = cc_table[(unsigned char)c];
+	} while (0x06u >> col & 1);
+	switch (col) {
+	case 0:	/* [a-zA-Z] */
+		state = 11;
+		goto dfa_accept;
+	case 3:	/* . */
+		goto dfa_s7;
+	default:
+		state = 5;
+		goto dfa_accept;
+	}
+
+/* state 6, stays on 0 */
+dfa_s6:
+	do {
+		DFA_ENTER(6);
+		DFA_GETC();
+		col = cc_table[(unsigned char)c];
+	} while (0x02u >> col & 1);
+	switch (col) {
+	case 3:	/* . */
+		goto dfa_s7;
+	case 5:	/* " */
+	case 6:	/* SEOF */
+	case 7:	/* other */
+		state = 5;
+		goto dfa_accept;
+	default:
+		state = 11;
+		goto dfa_accept;
+	}
+
+/* state 7, stays on 0 [1-9] */
+dfa_s7:
+	do {
+		DFA_ENTER(7);
+		DFA_GETC();
+		col = cc_table[(unsigned char)c];
+	} while (0x06u >> col & 1);
+	state = 8;
+	goto dfa_accept;
+
+/* state 9, stays on [a-zA-Z] 0 [1-9] . @ other */
+dfa_s9:
+	do {
+		DFA_ENTER(9);
+		DFA_GETC();
+		col = cc_table[(unsigned char)c];
+	} while (0x9Fu >> col & 1);
+	switch (col) {
+	case 6:	/* SEOF */
+		state = 12;
+		goto dfa_accept;
+	default:
+		state = 10;
+		goto dfa_accept;
+	}
+
+dfa_accept:
+	;
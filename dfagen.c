@@ -0,0 +1,227 @@
+/*
+ *	File name: dfagen.c
+ *	Compiler: any C99 compiler, built with table.c by "make dfa.h" (gcc / clang)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026, revised October 17th, 2026
+ *	Purpose: Generates dfa.h, the DFA of table.h coded directly: every state that isn't accepting becomes a
+ *			 label with a tight loop over its own transitions and a switch over the columns that leave it.
+ *			 malar_next_token_ctx() includes dfa.h in place of the get_next_state() loop when DFA_DIRECT is
+ *			 defined. It is a program of its own, built from this file and table.c (gcc dfagen.c table.c -o dfagen),
+ *			 "make dfa.h" builds and runs it whenever st_table, as_table or cc_table change.
+ *
+ *			 The generated code uses the locals c (the char just read), col and state of malar_next_token_ctx()
+ *			 and two macros the scanner defines: DFA_ENTER(s), run before state s reads a char, and DFA_GETC(),
+ *			 which reads the next char into c and counts the lines. It ends at the label dfa_accept with the
+ *			 accepting state in state.
+ *
+ *	Function list:  main()
+ *			emit_state()
+ *			reachable()
+ *			check_packed()
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>  /* fopen(), fprintf(), fclose() */
+#include <stdlib.h> /* exit codes */
+
+#include "table.h"
+
+#define ST_START 0	/* state the DFA starts in, with the first char already read */
+
+/* the column headers of table.h, for the comments of the generated code */
+static const char* col_name[TABLE_COLUMNS] = { "[a-zA-Z]", "0", "[1-9]", ".", "@", "\"", "SEOF", "other" };
+
+static int emit_state(FILE* fo, int s);
+static void reachable(int* seen, int s);
+static int check_packed(void);
+
+
+/*
+ *	Purpose: Writes dfa.h.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : check_packed(), reachable(), fopen(), fprintf(), emit_state(), fclose(), remove()
+ *	Parameters : argc: int, argument count
+ *				 argv: char**, argv[1] the file to write, dfa.h by default
+ *	Return value : EXIT_SUCCESS, or EXIT_FAILURE if the file can't be written, the tables can't be coded or
+ *				   tt_table doesn't match st_table and as_table
+ *	Algorithm : Code the states that can be reached from ST_START without going through an accepting state,
+ *				in state order, starting with ST_START.
+ */
+int main(int argc, char** argv)
+{
+	const char* name = argc > 1 ? argv[1] : "dfa.h"; /* file to write */
+	int seen[TABLE_ROWS] = { 0 }; /* the states to code */
+	FILE* fo; /* the generated file */
+	int s; /* state */
+	int ret = 0; /* return of emit_state() */
+
+	if (check_packed() != 0)
+		return EXIT_FAILURE;
+	reachable(seen, ST_START);
+	if ((fo = fopen(name, "w")) == NULL) {
+		fprintf(stderr, "dfagen: cannot write %s\n", name);
+		return EXIT_FAILURE;
+	}
+	fprintf(fo, "/*\tFile name:\tdfa.h\n");
+	fprintf(fo, " *\tPurpose:\tThe DFA of table.h coded directly, included by malar_next_token_ctx() with DFA_DIRECT.\n");
+	fprintf(fo, " *\t\t\t\tGenerated by dfagen from st_table, as_table and cc_table - DO NOT EDIT, run \"make dfa.h\".\n");
+	fprintf(fo, " */\n\n");
+	ret = emit_state(fo, ST_START);
+	for (s = 0; s < TABLE_ROWS && ret == 0; ++s)
+		if (seen[s] && s != ST_START)
+			ret = emit_state(fo, s);
+	fprintf(fo, "dfa_accept:\n\t;\n");
+	if (fclose(fo) != 0 || ret != 0) {
+		remove(name);
+		fprintf(stderr, "dfagen: %s not written\n", name);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+/*
+ *	Purpose: Codes one state that isn't accepting.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : fprintf()
+ *	Parameters : fo: FILE*, the generated file
+ *				 s: int, the state
+ *	Return value : 0 on success, 1 if the state has no transition for a column or ST_START can be re-entered
+ *	Algorithm : The columns that go back to s make a mask: s reads chars as long as the column of the char
+ *				is in it (ST_START starts with the char it was given). The other columns are grouped by the
+ *				state they go to, the biggest group is the default of the switch. A state that isn't
+ *				accepting is a jump to its label, an accepting one is stored in state.
+ */
+static int emit_state(FILE* fo, int s)
+{
+	unsigned int loop = 0; /* columns that stay in s */
+	int next; /* state a column goes to */
+	int col, k; /* columns */
+	int best = -1; /* first column of the biggest group, -1 if every column stays in s */
+	int size, best_size = 0; /* size of a group and of the biggest one */
+	int leave = 0; /* columns that leave s */
+
+	for (col = 0; col < TABLE_COLUMNS; ++col) {
+		next = st_table[s][col];
+		if (next == IS) {
+			fprintf(stderr, "dfagen: state %d has no transition for column %d\n", s, col);
+			return 1;
+		}
+		if (next == ST_START && s != ST_START) {
+			fprintf(stderr, "dfagen: state %d goes back to the start state\n", s);
+			return 1;
+		}
+		if (next == s)
+			loop |= 1u << col;
+		else
+			++leave;
+	}
+	for (col = 0; col < TABLE_COLUMNS; ++col) {
+		if (loop >> col & 1)
+			continue;
+		for (k = 0, size = 0; k < TABLE_COLUMNS; ++k)
+			size += st_table[s][k] == st_table[s][col];
+		if (size > best_size) {
+			best = col;
+			best_size = size;
+		}
+	}
+
+	fprintf(fo, "/* state %d", s);
+	if (loop) {
+		fprintf(fo, ", stays on");
+		for (col = 0; col < TABLE_COLUMNS; ++col)
+			if (loop >> col & 1)
+				fprintf(fo, " %s", col_name[col]);
+	}
+	fprintf(fo, " */\n");
+	if (s == ST_START) {
+		fprintf(fo, "\tcol = cc_table[(unsigned char)c];\n");
+		if (loop)
+			fprintf(fo, "\twhile (0x%02Xu >> col & 1) {\n\t\tDFA_ENTER(%d);\n\t\tDFA_GETC();\n"
+				"\t\tcol = cc_table[(unsigned char)c];\n\t}\n", loop, s);
+	}
+	else {
+		fprintf(fo, "dfa_s%d:\n", s);
+		if (loop)
+			fprintf(fo, "\tdo {\n\t\tDFA_ENTER(%d);\n\t\tDFA_GETC();\n\t\tcol = cc_table[(unsigned char)c];\n"
+				"\t} while (0x%02Xu >> col & 1);\n", s, loop);
+		else
+			fprintf(fo, "\tDFA_ENTER(%d);\n\tDFA_GETC();\n\tcol = cc_table[(unsigned char)c];\n", s);
+	}
+	if (best < 0)
+		return 0;	/* never leaves s, the sentinel has to be one of its columns */
+	next = st_table[s][best];
+	if (best_size == leave) {	/* leaves s for one state only */
+		if (as_table[next] == NOAS)
+			fprintf(fo, "\tgoto dfa_s%d;\n\n", next);
+		else
+			fprintf(fo, "\tstate = %d;\n\tgoto dfa_accept;\n\n", next);
+		return 0;
+	}
+
+	fprintf(fo, "\tswitch (col) {\n");
+	for (col = 0; col < TABLE_COLUMNS; ++col) {
+		next = st_table[s][col];
+		if (loop >> col & 1 || next == st_table[s][best])
+			continue;
+		for (k = 0; k < col && st_table[s][k] != next; ++k)
+			;
+		if (k < col)
+			continue;	/* the group was coded with its first column */
+		for (k = col; k < TABLE_COLUMNS; ++k)
+			if (st_table[s][k] == next)
+				fprintf(fo, "\tcase %d:\t/* %s */\n", k, col_name[k]);
+		if (as_table[next] == NOAS)
+			fprintf(fo, "\t\tgoto dfa_s%d;\n", next);
+		else
+			fprintf(fo, "\t\tstate = %d;\n\t\tgoto dfa_accept;\n", next);
+	}
+	next = st_table[s][best];
+	fprintf(fo, "\tdefault:\n");
+	if (as_table[next] == NOAS)
+		fprintf(fo, "\t\tgoto dfa_s%d;\n\t}\n\n", next);
+	else
+		fprintf(fo, "\t\tstate = %d;\n\t\tgoto dfa_accept;\n\t}\n\n", next);
+	return 0;
+}
+
+
+/* Checks that tt_table is st_table with the as_table flags of each next state, the scanner interprets it
+   unless DFA_DIRECT is defined. Returns 0 if they agree, 1 (after listing the transitions that differ) if not */
+static int check_packed(void) {
+	int s, col; /* state and column */
+	int next; /* next state of st_table */
+	int packed; /* what tt_table should hold */
+	int ret = 0; /* return value */
+
+	for (s = 0; s < TABLE_ROWS; ++s)
+		for (col = 0; col < TABLE_COLUMNS; ++col) {
+			next = st_table[s][col];
+			if (next == IS)
+				packed = TT_IS;
+			else
+				packed = next | (as_table[next] != NOAS ? TT_ACCEPT : 0) | (as_table[next] == ASWR ? TT_RETRACT : 0);
+			if ((next != IS && next >= TT_IS) || tt_table[s][col] != packed) {
+				fprintf(stderr, "dfagen: tt_table[%d][%d] is 0x%02X, st_table and as_table give 0x%02X\n",
+					s, col, tt_table[s][col], packed);
+				ret = 1;
+			}
+		}
+	return ret;
+}
+
+
+/* Marks the states that can be reached from s without going through an accepting state */
+static void reachable(int* seen, int s) {
+	int col; /* column */
+	if (seen[s] || as_table[s] != NOAS)
+		return;
+	seen[s] = 1;
+	for (col = 0; col < TABLE_COLUMNS; ++col)
+		if (st_table[s][col] != IS)
+			reachable(seen, st_table[s][col]);
+}
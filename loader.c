@@ -0,0 +1,225 @@
+/*
+ *	File name: loader.c
+ *	Compiler: MS Visual Studio 2019 (Windows threads), gcc / clang with -lpthread (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026
+ *	Purpose: Implements the double-buffered read-ahead loader. The reader thread fills one block while the
+ *			 consumer drains the other, so reading the source file overlaps with scanning and parsing.
+ *			 The consumer only waits when it catches up with the reader.
+ *
+ *	Function list:  l_open()
+ *			l_refill()
+ *			l_close()
+ *			l_reader()
+ */
+
+#include <stdlib.h> /* malloc(), free() */
+#include <string.h> /* memcpy() */
+
+#include "loader.h"
+
+/* the minimum needed from the platform thread library: one thread, one lock, one condition */
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE l_thread;
+typedef CRITICAL_SECTION l_mutex;
+typedef CONDITION_VARIABLE l_cond;
+#define L_THREAD_RETURN DWORD WINAPI
+#define l_thread_start(t, f, a) (((t) = CreateThread(NULL, 0, (f), (a), 0, NULL)) != NULL)
+#define l_thread_join(t) (WaitForSingleObject((t), INFINITE), CloseHandle(t))
+#define l_mutex_init(m) InitializeCriticalSection(m)
+#define l_mutex_destroy(m) DeleteCriticalSection(m)
+#define l_lock(m) EnterCriticalSection(m)
+#define l_unlock(m) LeaveCriticalSection(m)
+#define l_cond_init(c) InitializeConditionVariable(c)
+#define l_cond_destroy(c) ((void)(c))
+#define l_wait(c, m) SleepConditionVariableCS((c), (m), INFINITE)
+#define l_signal(c) WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+typedef pthread_t l_thread;
+typedef pthread_mutex_t l_mutex;
+typedef pthread_cond_t l_cond;
+#define L_THREAD_RETURN void*
+#define l_thread_start(t, f, a) (pthread_create(&(t), NULL, (f), (a)) == 0)
+#define l_thread_join(t) pthread_join((t), NULL)
+#define l_mutex_init(m) pthread_mutex_init((m), NULL)
+#define l_mutex_destroy(m) pthread_mutex_destroy(m)
+#define l_lock(m) pthread_mutex_lock(m)
+#define l_unlock(m) pthread_mutex_unlock(m)
+#define l_cond_init(c) pthread_cond_init((c), NULL)
+#define l_cond_destroy(c) pthread_cond_destroy(c)
+#define l_wait(c, m) pthread_cond_wait((c), (m))
+#define l_signal(c) pthread_cond_broadcast(c)
+#endif
+
+/* loader state shared by the reader thread and the consumer */
+struct Loader {
+	FILE* fi;			/* source file, only touched by the reader thread once it started */
+	char* block[2];		/* the two blocks, the reader fills one while the consumer drains the other */
+	size_t len[2];		/* number of chars in each block, 0 marks the end of the file */
+	int full[2];		/* 1 if the block was filled and not yet drained, guarded by lock */
+	size_t size;		/* capacity of each block */
+	size_t pos;			/* consumer position in block[cur] */
+	int cur;			/* block the consumer is draining */
+	int stop;			/* set by l_close() to make the reader quit early, guarded by lock */
+	l_mutex lock;		/* guards full[] and stop */
+	l_cond changed;		/* signalled whenever full[] or stop changes */
+	l_thread reader;	/* the reader thread */
+};
+
+static L_THREAD_RETURN l_reader(void* arg);
+
+
+/*
+ *	Purpose: Creates a loader for fi and starts its reader thread
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : calloc(), malloc(), free(), l_thread_start()
+ *	Parameters : fi: A valid pointer to a FILE struct, owned by the loader's thread until l_close()
+ *				 block_size: size_t, bytes per block, 0 for LOADER_BLOCK
+ *	Return value : A valid pointer to a loader or NULL if error
+ *	Algorithm : N/A
+ */
+pLoader l_open(FILE* const fi, size_t block_size)
+{
+	pLoader pLD; /* the new loader */
+
+	if (fi == NULL)  return NULL;
+	if (!(pLD = (Loader*)calloc(1, sizeof(Loader))))
+		return NULL;
+
+	pLD->fi = fi;
+	pLD->size = block_size ? block_size : LOADER_BLOCK;
+	if (!(pLD->block[0] = (char*)malloc(pLD->size)) || !(pLD->block[1] = (char*)malloc(pLD->size))) {
+		free(pLD->block[0]);
+		free(pLD);
+		return NULL;
+	}
+	l_mutex_init(&pLD->lock);
+	l_cond_init(&pLD->changed);
+
+	if (!l_thread_start(pLD->reader, l_reader, pLD)) {
+		l_cond_destroy(&pLD->changed);
+		l_mutex_destroy(&pLD->lock);
+		free(pLD->block[0]);
+		free(pLD->block[1]);
+		free(pLD);
+		return NULL;
+	}
+	return pLD;
+}
+
+
+/*
+ *	Purpose: Refill callback for a STREAM_MODE buffer, copies chars from the block the reader finished last
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : memcpy(), l_lock(), l_unlock(), l_wait(), l_signal()
+ *	Parameters : loader: void*, a valid pointer to a Loader
+ *				 dst: char*, where to put the chars
+ *				 n: size_t, maximum number of chars to copy
+ *	Return value : the number of chars copied, 0 at the end of the file
+ *	Algorithm : The consumer owns block[cur] while it is full, so the copy needs no lock. The lock is only
+ *				taken to wait for the block and to give it back once it is drained. As long as the reader
+ *				keeps ahead, the consumer never waits.
+ */
+size_t l_refill(void* loader, char* dst, size_t n)
+{
+	pLoader pLD = (pLoader)loader; /* the loader to read from */
+
+	if (pLD == NULL || n == 0)  return 0;
+
+	l_lock(&pLD->lock);
+	while (!pLD->full[pLD->cur])
+		l_wait(&pLD->changed, &pLD->lock);
+	l_unlock(&pLD->lock);
+
+	/* the reader marks the end of the file with an empty block and stops, leave it full */
+	if (pLD->len[pLD->cur] == 0)
+		return 0;
+
+	if (n > pLD->len[pLD->cur] - pLD->pos)
+		n = pLD->len[pLD->cur] - pLD->pos;
+	memcpy(dst, pLD->block[pLD->cur] + pLD->pos, n);
+
+	/* block drained, hand it back to the reader and move on to the other one */
+	if ((pLD->pos += n) == pLD->len[pLD->cur]) {
+		l_lock(&pLD->lock);
+		pLD->full[pLD->cur] = 0;
+		l_signal(&pLD->changed);
+		l_unlock(&pLD->lock);
+		pLD->cur ^= 1;
+		pLD->pos = 0;
+	}
+	return n;
+}
+
+
+/*
+ *	Purpose: Stops the reader thread and frees the loader. The FILE is left open for the caller to close.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : l_lock(), l_unlock(), l_signal(), l_thread_join(), free()
+ *	Parameters : pLD: A valid pointer to a Loader
+ *	Return value : N/A
+ *	Algorithm : N/A
+ */
+void l_close(pLoader const pLD)
+{
+	if (pLD == NULL)  return;
+
+	l_lock(&pLD->lock);
+	pLD->stop = 1;
+	l_signal(&pLD->changed);
+	l_unlock(&pLD->lock);
+	l_thread_join(pLD->reader);
+
+	l_cond_destroy(&pLD->changed);
+	l_mutex_destroy(&pLD->lock);
+	free(pLD->block[0]);
+	free(pLD->block[1]);
+	free(pLD);
+}
+
+
+/*
+ *	Purpose: Body of the reader thread, fills the blocks alternately until the end of the file
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : fread(), l_lock(), l_unlock(), l_wait(), l_signal()
+ *	Parameters : arg: void*, the Loader
+ *	Return value : 0
+ *	Algorithm : Wait for the next block to be drained, fill it outside the lock, publish it. A short or
+ *				empty read means the end of the file: an empty block is published as the end marker.
+ */
+static L_THREAD_RETURN l_reader(void* arg)
+{
+	pLoader pLD = (pLoader)arg; /* the loader to fill */
+	int next = 0;				/* block to fill next */
+	size_t len;					/* # of chars read into it */
+
+	for (;;) {
+		l_lock(&pLD->lock);
+		while (pLD->full[next] && !pLD->stop)
+			l_wait(&pLD->changed, &pLD->lock);
+		if (pLD->stop) {
+			l_unlock(&pLD->lock);
+			break;
+		}
+		l_unlock(&pLD->lock);
+
+		len = fread(pLD->block[next], 1, pLD->size, pLD->fi);
+
+		l_lock(&pLD->lock);
+		pLD->len[next] = len;
+		pLD->full[next] = 1;
+		l_signal(&pLD->changed);
+		l_unlock(&pLD->lock);
+
+		if (len == 0)
+			break;
+		next ^= 1;
+	}
+	return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+/*
+ *	File name: loader.h
+ *	Compiler: MS Visual Studio 2019 (Windows threads), gcc / clang with -lpthread (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026
+ *	Purpose: Declares the double-buffered read-ahead loader. A background thread reads the next block of a
+ *			 source file while the scanner consumes the current one, and hands blocks over to a STREAM_MODE
+ *			 buffer through l_refill(), which matches PTR_REFILL.
+ *			 On POSIX systems the program must be linked with -lpthread.
+ *
+ *	Function list: N/A (no function definitions, only declarations)
+ */
+
+#ifndef LOADER_H_
+#define LOADER_H_
+
+#include <stdio.h>  /* FILE */
+#include <stddef.h> /* size_t */
+
+#define LOADER_BLOCK 65536 /* default size of each of the two blocks */
+
+typedef struct Loader Loader, * pLoader; /* defined in loader.c, only used through a pointer */
+
+/* function declarations */
+pLoader l_open(FILE* const fi, size_t block_size);
+size_t l_refill(void* loader, char* dst, size_t n);
+void l_close(pLoader const pLD);
+
+#endif
@@ -17,7 +17,7 @@
 #define NO_ATTR (-1)	/* attribute for non-enumerated tokens */
 
 /* external linkage to utilities required by the parser */
-extern char* kw_table[];
+extern const char* const kw_table[];
 extern int line;
 extern pBuffer str_LTBL;
 extern Token malar_next_token(void);
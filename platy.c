@@ -12,14 +12,19 @@
 #include <stdarg.h>
 #include "buffer.h"
 #include "token.h"
+#include "loader.h"
+#include "scanner.h"
+#include "tcache.h"
+#include "pscan.h"
 
 /*  Input buffer parameters  */
 #define INIT_CAPACITY 200	/*  initial buffer capacity  */
 #define INC_FACTOR 15       /*  increment factor  */
+#define STREAM_CAPACITY 65536	/*  initial ring size when the source can only be streamed  */
 
 /*  String Literal Table parameters  */
 #define STR_INIT_CAPACITY 100	/*  initial string literal table capacity  */
-#define STR_CAPACITY_INC  50	/*  initial string literal table capacity inc  */
+#define STR_CAPACITY_INC  100	/*  string literal table capacity inc - percent, 100 doubles the capacity  */
 
 /*  check for ANSI C compliancy  */
 #define ANSI_C 0
@@ -30,6 +35,10 @@
 
 /*  Global objects - variables  */
 static pBuffer sc_buf;	/*  pointer to input (source) buffer  */
+static FILE* sc_src;	/*  source file a stream mode sc_buf is still reading from  */
+static pLoader sc_loader;	/*  read-ahead thread feeding a stream mode sc_buf  */
+static TokenStream sc_tokens;	/*  tokens of the source, read from the token cache or scanned to be cached  */
+static SymbolTable sym_TBL;		/*  variables of the source, installed by the scanner  */
 pBuffer str_LTBL;		/*  this buffer implements String Literal Table  */
 						/*  it is used as a repository for string literals  */
 int scerrnum;			/*  run-time error number = 0 by default (ANSI)  */
@@ -40,7 +49,6 @@ extern int line;		/*  source code line number - defined in scanner.c  */
 
 /*  function declarations (prototypes)  */
 extern void parser(void);
-extern void scanner_init(pBuffer sc_buf);
 
 /*  For testing purposes  */
 extern Token malar_next_token(void);
@@ -49,13 +57,18 @@ static void err_printf(char *fmt, ...);
 static void display(Buffer* ptrBuffer); 
 static long get_filesize(char *fname);
 static void garbage_collect(void);
+static void scan_cached(Buffer* ptrBuffer);
+#ifdef B_STATS
+static void display_stats(char* name, Buffer* ptrBuffer);
+#endif
 
 
-/*  main function takes a PLATYPUS source file as an argument at the command line. usage: parser source_file_name */    
+/*  main function takes a PLATYPUS source file as an argument at the command line. usage: parser source_file_name
+	A file name of - reads the source from the standard input  */    
 int main(int argc, char** argv)
 {
 	FILE* fi;				/*  input file handle  */
-    int loadsize = 0;		/*  the size of the file loaded in the buffer  */
+    size_t loadsize = 0;	/*  the size of the file loaded in the buffer  */
     int ansi_c = !ANSI_C;	/*  ANSI C flag  */
 
 	/*  Check if the compiler option is set to compile ANSI C __DATE__, __TIME__, __LINE__,
@@ -72,19 +85,19 @@ int main(int argc, char** argv)
 		err_printf("Date: %s  Time: %s", __DATE__, __TIME__);
 		err_printf("Runtime error at line %d in file %s", __LINE__, __FILE__);
 		err_printf("%s%s%s", argv[0], ": ", "Missing source file name.");
-		err_printf("%s%s%s","Usage: ", "parser", " source_file_name");
+		err_printf("%s%s%s","Usage: ", "parser", " source_file_name | -");
 		exit(EXIT_FAILURE);
 	}	
 
-	/*  create a source code input buffer - multiplicative mode  */	
-	sc_buf = b_allocate(INIT_CAPACITY, INC_FACTOR, 'm');
+	/*  create a source code input buffer - read-only mode, the file is mapped instead of copied  */	
+	sc_buf = b_allocate(0, 0, 'r');
 	if (sc_buf == NULL) {
 		err_printf("%s%s%s", argv[0], ": ", "Could not create source buffer");
 		exit(EXIT_FAILURE);
 	}
 
 	/*  open source file  */
-	if ((fi = fopen(argv[1], "r")) == NULL) {
+	if ((fi = strcmp(argv[1], "-") ? fopen(argv[1], "r") : stdin) == NULL) {
 		err_printf("%s%s%s%s", argv[0], ": " , "Cannot open file: ", argv[1]);
 		exit(1);
 	}
@@ -92,12 +105,30 @@ int main(int argc, char** argv)
 	/*  load source file into input buffer  */
     printf("Reading file %s ....Please wait\n", argv[1]);
     loadsize = b_load(fi, sc_buf);
+
+	/*  the file can't be mapped (a pipe or a device) - stream it through a ring buffer,
+		only the chars the scanner still needs are kept in memory. A read-ahead thread reads
+		the next block while the scanner works on the current one  */
+	if (loadsize == RT_FAIL_1) {
+		b_free(sc_buf);
+		if ((sc_buf = b_allocate(STREAM_CAPACITY, 0, 'i')) == NULL) {
+			err_printf("%s%s%s", argv[0], ": ", "Could not create source buffer");
+			exit(EXIT_FAILURE);
+		}
+		if ((sc_loader = l_open(fi, STREAM_CAPACITY)) != NULL)
+			loadsize = b_source(sc_buf, l_refill, sc_loader) ? 0 : RT_FAIL_1;
+		else
+			loadsize = b_load(fi, sc_buf);
+	}
     
 	if (loadsize == RT_FAIL_1)
 		err_printf("%s%s%s", argv[0], ": ", "Error in loading buffer.");
 
-	/*  close source file  */	
- 	fclose(fi);
+	/*  close source file - a stream mode buffer keeps reading from it while scanning  */	
+	if (b_mode(sc_buf) == STREAM_MODE)
+		sc_src = fi;
+	else
+		fclose(fi);
 	
 	/*  find the size of the file  */
     if (loadsize == LOAD_FAIL) {
@@ -105,13 +136,13 @@ int main(int argc, char** argv)
      printf("Input file size: %ld\n", get_filesize(argv[1]));
     }
 
-	/*  Add SEOF (EOF) to input buffer and display the source buffer  */
-      if (b_compact(sc_buf, EOF)) {
+	/*  Add SEOF (EOF) to input buffer and display the source buffer (a stream can only be read once)  */
+      if (b_compact(sc_buf, EOF) && b_mode(sc_buf) != STREAM_MODE) {
 		display(sc_buf);
       }
 
-	/*  create string Literal Table  */	
-	str_LTBL = b_allocate(INIT_CAPACITY, INC_FACTOR, 'a');
+	/*  create string Literal Table - multiplicative mode so appends stay amortized O(1)  */	
+	str_LTBL = b_allocate_as(STR_INIT_CAPACITY, STR_CAPACITY_INC, MULTIPLICATIVE_MODE);
 	if (str_LTBL == NULL) {
 		err_printf("%s%s%s", argv[0], ": ", "Could not create string literal buffer");
 		exit(EXIT_FAILURE);
@@ -122,8 +153,14 @@ int main(int argc, char** argv)
 	
 	/*  Testbed for buffer, scanner,symbol table and parser  */
 
-	/*  Initialize scanner  */
+	/*  Initialize scanner, it installs the variables in the symbol table  */
 	scanner_init(sc_buf);
+	scanner_symbols(&sym_TBL);
+
+	/*  the parser gets the tokens of a source that was scanned before from the token cache.
+		a stream can only be read once, it is scanned as the parser goes  */
+	if (b_mode(sc_buf) != STREAM_MODE)
+		scan_cached(sc_buf);
 
 	/*  Start parsing  */
 	printf("\nParsing the source file...\n\n");
@@ -172,8 +209,8 @@ long get_filesize(char  *fname)
 void display (Buffer *ptrBuffer)
 {
 	printf("\nPrinting input buffer parameters:\n\n");
-	printf("The capacity of the buffer is:  %d\n", b_capacity(ptrBuffer));
-	printf("The current size of the buffer is:  %d\n", b_limit(ptrBuffer)); 
+	printf("The capacity of the buffer is:  %zu\n", b_capacity(ptrBuffer));
+	printf("The current size of the buffer is:  %zu\n", b_limit(ptrBuffer)); 
 	printf("\nPrinting input buffer contents:\n\n");
 	b_rewind(ptrBuffer);
 	b_print(ptrBuffer, 8);
@@ -189,8 +226,84 @@ void garbage_collect(void)
 		printf("\nSyntax errors: %d\n",synerrno);
   
 	printf("\nCollecting garbage...\n");
+#ifdef B_STATS
+	if (sc_buf != NULL)
+		display_stats("sc_buf", sc_buf);
+	if (str_LTBL != NULL)
+		display_stats("str_LTBL", str_LTBL);
+#endif
 	b_free(sc_buf);
 	b_free(str_LTBL);  
+	ts_free(&sc_tokens);
+	st_free(&sym_TBL);
+#ifdef B_STATS
+	display_stats("all buffers", NULL);
+#endif
+	b_release();
+	l_close(sc_loader);
+	if (sc_src != NULL)
+		fclose(sc_src);
 }
 
 
+
+/*  The function gets the tokens of the source from the token cache, or scans all of them and caches them
+	if the source isn't cached yet or has changed, on one thread per processor when the source is large.
+	The cache is only used when the PLATY_CACHE environment variable names its directory, a cache that
+	can't be written is left alone. Without a cache a source too small for threads isn't scanned ahead,
+	the parser scans it as it goes. Otherwise the scanner then replays the tokens to the parser.
+	If the source can't be scanned in full (a run-time error) the parser scans it as usual  */
+void scan_cached(Buffer* ptrBuffer)
+{
+	ScannerContext ctx = { 0 };	/*  context of the full scan  */
+	size_t size = b_limit(ptrBuffer);	/*  source chars, with the SEOF sentinel  */
+	char* src;	/*  the source chars  */
+	const char* dir = getenv(TC_ENV);	/*  cache directory, NULL for no cache  */
+	unsigned long long hash = 0;	/*  key of the cache file  */
+
+	if (dir != NULL && *dir == '\0')
+		dir = NULL;
+	if (dir == NULL && ps_chunks(size - 1, 0) < 2)
+		return;	/*  nothing to gain from scanning ahead, scanner_init() was called already  */
+	if ((src = b_view(ptrBuffer, 0, size, NULL)) == NULL)
+		return;
+	if (dir != NULL)
+		hash = tc_hash(src, size);
+	if (dir == NULL || tc_load(dir, hash, size, &sc_tokens, str_LTBL, &sym_TBL) != 0) {
+		ts_free(&sc_tokens);	/*  whatever tc_load() read before it gave up  */
+		st_free(&sym_TBL);
+		if (ps_chunks(size - 1, 0) < 2 || malar_scan_parallel(ptrBuffer, &sc_tokens, str_LTBL, &sym_TBL, 0) != 0) {
+			ts_free(&sc_tokens);	/*  too small for threads, or the serial scan finds the error or has the memory  */
+			st_free(&sym_TBL);
+			scanner_init_ctx(&ctx, ptrBuffer, str_LTBL);	/*  also clears str_LTBL  */
+			ctx.symbols = &sym_TBL;
+			malar_next_tokens(&ctx, &sc_tokens, (size_t)-1);
+			scanner_free_ctx(&ctx);
+		}
+		if (ctx.scerrnum != 0 || sc_tokens.count == 0 || sc_tokens.token[sc_tokens.count - 1].code != SEOF_T) {
+			ts_free(&sc_tokens);
+			st_free(&sym_TBL);
+			scanner_init(ptrBuffer);
+			return;
+		}
+		if (dir != NULL)
+			tc_save(dir, hash, size, &sc_tokens, str_LTBL);	/*  a read-only or full disk only costs the next run a scan  */
+	}
+	scanner_replay(&sc_tokens);
+}
+
+
+#ifdef B_STATS
+/*  The function displays the counters kept by a buffer, or the totals of the freed buffers if ptrBuffer is NULL  */
+void display_stats(char* name, Buffer* ptrBuffer)
+{
+	BufferStats stats;
+
+	if (b_stats(ptrBuffer, &stats) != 0)
+		return;
+	printf("\nBuffer counters for %s:\n", name);
+	printf("  grows: %zu  moves: %zu  bytes copied: %zu  peak capacity: %zu\n",
+		stats.grows, stats.moves, stats.copied, stats.peak);
+	printf("  b_getc() calls: %zu  b_retract() calls: %zu\n", stats.getcs, stats.retracts);
+}
+#endif
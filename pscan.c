@@ -0,0 +1,324 @@
+/*
+ *	File name: pscan.c
+ *	Compiler: MS Visual Studio 2019 (Windows threads), gcc / clang with -lpthread (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026, revised October 17th, 2026
+ *	Purpose: Implements the parallel scan. A quick pass over the source follows just enough of the scanner to
+ *			 know where a string literal or a comment is open, and cuts the source after line terminators
+ *			 outside them, where the serial scanner is between two tokens. Each chunk is scanned in place,
+ *			 through a shared cursor of the source and a context that stops at the end of the chunk, with its
+ *			 own string literal table and symbol table. Then the chunks are joined in order: lines and string
+ *			 literal offsets are moved by what comes before the chunk, and the identifiers are installed in
+ *			 the symbol table in the order a serial scan meets them.
+ *
+ *	Function list:  malar_scan_parallel()
+ *			ps_chunks()
+ *			ps_cut()
+ *			ps_join()
+ *			ps_scan()
+ *			ps_worker()
+ *			ps_cpus()
+ */
+
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* memset() */
+
+#include "pscan.h"
+#include "table.h"	/* SEOF, SEOB */
+
+/* the platform thread library, only a thread start and join are needed */
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE ps_thread;
+#define PS_THREAD_RETURN DWORD WINAPI
+#define ps_thread_start(t, f, a) (((t) = CreateThread(NULL, 0, (f), (a), 0, NULL)) != NULL)
+#define ps_thread_join(t) (WaitForSingleObject((t), INFINITE), CloseHandle(t))
+#else
+#include <pthread.h>
+#include <unistd.h> /* sysconf() */
+typedef pthread_t ps_thread;
+#define PS_THREAD_RETURN void*
+#define ps_thread_start(t, f, a) (pthread_create(&(t), NULL, (f), (a)) == 0)
+#define ps_thread_join(t) pthread_join((t), NULL)
+#endif
+
+/* states of the cutting pass */
+#define PS_TOP 0	/* between tokens, or in a token that can't hold a '"', a '!' or a line terminator */
+#define PS_STRING 1	/* in a string literal */
+#define PS_BANG 2	/* right after a '!', the scanner takes the next char whatever it is */
+#define PS_LINE 3	/* in the rest of the line the scanner skips after a '!' and the char after it */
+
+/* the chars the scanner skips in one run as white space */
+#define ps_blank(c) ((c) == ' ' || (c) == '\t' || (c) == '\v' || (c) == '\f' || (c) == '\r' || (c) == '\n')
+
+/* one chunk of the source and what its worker makes of it */
+typedef struct PChunk {
+	pBuffer cursor;		/* shared cursor of the source the chunk is read through */
+	size_t start;		/* offset of the chunk in the source */
+	size_t end;			/* offset of the next chunk, 0 for the last one */
+	TokenStream ts;		/* tokens of the chunk */
+	pBuffer str_LTBL;	/* string literals of the chunk */
+	SymbolTable st;		/* identifiers of the chunk */
+	int lines;			/* lines the scanner counted in the chunk */
+	int failed;			/* the chunk couldn't be scanned in full */
+} PChunk;
+
+static size_t ps_cut(const char* src, size_t n, size_t* cuts, size_t chunks);
+static int ps_join(PChunk* chunk, size_t chunks, pTokenStream ts, pBuffer str_LTBL, pSymbolTable st);
+static void ps_scan(PChunk* pc);
+static PS_THREAD_RETURN ps_worker(void* arg);
+static int ps_cpus(void);
+
+
+/*
+ *	Purpose: Scans a whole source on several threads into a token stream, the same stream, string literal
+ *			 table and symbol table that malar_next_tokens() gives with a context that has st.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_limit(), b_view(), b_clear(), ps_chunks(), ps_cut(), calloc(), free(), b_share(),
+ *					   ps_thread_start(), ps_thread_join(), ps_worker(), ps_scan(), ps_join(), ts_free(),
+ *					   st_free(), b_free()
+ *	Parameters : sc_buf: pBuffer, the source, compacted with the SEOF sentinel and contiguous (not SEGMENTED_MODE
+ *						 nor STREAM_MODE). It is shared with b_share(), so it is in SHARED_MODE (read only)
+ *						 from then on, its text isn't copied nor changed.
+ *				 ts: pTokenStream, an empty token stream that receives the tokens
+ *				 str_LTBL: pBuffer, the string literal table, cleared first
+ *				 st: pSymbolTable, an empty symbol table that receives the identifiers
+ *				 threads: int, the most threads to use, 0 for one per processor
+ *	Return value : 0 on success, 1 if the source can't be scanned in parallel or a chunk couldn't be scanned
+ *				   (out of memory), ts, str_LTBL and st must then be emptied before they are used again.
+ *	Algorithm : Cut the source into ps_chunks() chunks, give each one a shared cursor of the source, scan
+ *				them all at once, the last one on this thread, and join them. A source too small for two
+ *				chunks is scanned on this thread the same way, a caller that has a serial path takes it then.
+ */
+int malar_scan_parallel(pBuffer sc_buf, pTokenStream ts, pBuffer str_LTBL, pSymbolTable st, int threads)
+{
+	size_t n = b_limit(sc_buf); /* chars of the source with the sentinel */
+	const char* src = b_view(sc_buf, 0, n, NULL); /* the source */
+	size_t cuts[PS_MAX_THREADS + 1]; /* offset of each chunk, then the end */
+	ps_thread tid[PS_MAX_THREADS]; /* worker of each chunk */
+	int started[PS_MAX_THREADS]; /* the worker of the chunk is running */
+	PChunk* chunk; /* the chunks */
+	size_t chunks; /* number of chunks */
+	size_t i; /* chunk index */
+	int ret = 0; /* return value */
+
+	if (src == NULL || n == 0 || (unsigned char)src[n - 1] != SEOF || b_clear(str_LTBL) != 0)
+		return 1;
+	--n;	/* the sentinel ends the last chunk */
+	chunks = ps_cut(src, n, cuts, ps_chunks(n, threads));
+	if ((chunk = (PChunk*)calloc(chunks, sizeof(PChunk))) == NULL)
+		return 1;
+
+	/* the cursors are made here, b_share() turns sc_buf into a shared buffer the first time */
+	for (i = 0; i < chunks; ++i) {
+		chunk[i].start = cuts[i];
+		chunk[i].end = i + 1 < chunks ? cuts[i + 1] : 0;
+		ts_init(&chunk[i].ts);
+		st_init(&chunk[i].st);
+		if ((chunk[i].cursor = b_share(sc_buf)) == NULL)
+			ret = 1;
+	}
+	for (i = 0; i < chunks; ++i)	/* the last chunk is scanned on this thread */
+		started[i] = ret == 0 && i + 1 < chunks && ps_thread_start(tid[i], ps_worker, &chunk[i]);
+	for (i = 0; i < chunks && ret == 0; ++i)
+		if (!started[i])
+			ps_scan(&chunk[i]);
+	for (i = 0; i < chunks; ++i)
+		if (started[i])
+			ps_thread_join(tid[i]);
+
+	if (ret == 0)
+		ret = ps_join(chunk, chunks, ts, str_LTBL, st);
+	for (i = 0; i < chunks; ++i) {
+		ts_free(&chunk[i].ts);
+		st_free(&chunk[i].st);
+		b_free(chunk[i].str_LTBL);
+		b_free(chunk[i].cursor);
+	}
+	free(chunk);
+	return ret;
+}
+
+
+/* Number of chunks malar_scan_parallel() cuts a source of n chars into with at most threads threads (0 for
+   one per processor): one per thread, each of at least PS_MIN_CHUNK chars, at least one */
+size_t ps_chunks(size_t n, int threads) {
+	size_t chunks; /* the number of chunks */
+	if (threads <= 0)
+		threads = ps_cpus();
+	chunks = threads > PS_MAX_THREADS ? PS_MAX_THREADS : (size_t)threads;
+	if (chunks > n / PS_MIN_CHUNK)
+		chunks = n / PS_MIN_CHUNK;
+	return chunks > 0 ? chunks : 1;
+}
+
+
+/*
+ *	Purpose: Cuts the source into chunks that start where the serial scanner is between two tokens.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : None
+ *	Parameters : src: const char*, the source
+ *				 n: size_t, chars of the source without the sentinel
+ *				 cuts: size_t*, receives the offset of each chunk followed by n
+ *				 chunks: size_t, the number of chunks wanted
+ *	Return value : size_t, the number of chunks made, at most chunks
+ *	Algorithm : Follow the scanner through the chars that open and close what can span lines: a '"' opens
+ *				a string literal up to the next '"'. A '!' makes the scanner take the next char whatever it is
+ *				and skip to the end of the line. A '\n' read outside of them ends a line between two tokens, and
+ *				the first one at or after k * n / chunks that is followed by a char that starts a token starts
+ *				chunk k: the scanner skips white space in runs that may span lines, a cut in one could be
+ *				passed over. No cut is made after a SEOB or SEOF char in the source, the serial scan ends
+ *				there, the rest goes to the last chunk.
+ */
+static size_t ps_cut(const char* src, size_t n, size_t* cuts, size_t chunks)
+{
+	size_t k = 1; /* next chunk to start */
+	size_t i; /* offset of the char read */
+	int state = PS_TOP; /* state of the pass */
+	unsigned char c; /* the char read */
+
+	cuts[0] = 0;
+	for (i = 0; i < n && k < chunks; ++i) {
+		c = (unsigned char)src[i];
+		if (c == SEOB || c == SEOF)
+			break;
+		switch (state) {
+		case PS_TOP:
+			if (c == '"')
+				state = PS_STRING;
+			else if (c == '!')
+				state = PS_BANG;
+			break;
+		case PS_STRING:
+			if (c == '"')
+				state = PS_TOP;
+			break;
+		case PS_BANG:
+			state = PS_LINE;
+			break;
+		default:	/* PS_LINE */
+			if (c == '\r' || c == '\n')
+				state = PS_TOP;
+		}
+		if (state == PS_TOP && c == '\n' && i + 1 >= k * (n / chunks) && i + 1 < n && !ps_blank(src[i + 1]))
+			cuts[k++] = i + 1;
+	}
+	cuts[k] = n;
+	return k;
+}
+
+
+/*
+ *	Purpose: Scans one chunk.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_allocate_as(), scanner_init_ctx(), b_mark(), b_reset(), malar_next_tokens(),
+ *					   b_getcoffset(), scanner_free_ctx()
+ *	Parameters : pc: PChunk*, the chunk
+ *	Return value : N/A
+ *	Algorithm : Move the cursor of the chunk to its start and scan with a context of its own that ends at
+ *				the start of the next chunk, where the last token of the chunk (SEOF_T) must start.
+ */
+static void ps_scan(PChunk* pc)
+{
+	ScannerContext ctx; /* context of the chunk */
+
+	memset(&ctx, 0, sizeof(ctx));
+	pc->failed = 1;
+	pc->str_LTBL = b_allocate_as(PS_STR_CAPACITY, 100, MULTIPLICATIVE_MODE);
+	if (pc->str_LTBL != NULL && scanner_init_ctx(&ctx, pc->cursor, pc->str_LTBL) == 0
+		&& b_mark(pc->cursor, pc->start) == pc->start && b_reset(pc->cursor) == pc->start) {
+		ctx.end = pc->end;
+		ctx.symbols = &pc->st;
+		malar_next_tokens(&ctx, &pc->ts, (size_t)-1);
+		pc->lines = ctx.line - 1;
+		pc->failed = ctx.scerrnum != 0 || pc->ts.count == 0 || pc->ts.token[pc->ts.count - 1].code != SEOF_T
+			|| (pc->end != 0 && b_getcoffset(pc->cursor) != pc->end);
+	}
+	scanner_free_ctx(&ctx);
+}
+
+
+/* Scans one chunk on its worker thread, then frees the buffer pool of the thread, the results of the chunk
+   are freed by the caller's */
+static PS_THREAD_RETURN ps_worker(void* arg) {
+	ps_scan((PChunk*)arg);
+	b_release();
+	return 0;
+}
+
+
+/*
+ *	Purpose: Joins the chunks into one token stream, string literal table and symbol table.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_limit(), b_view(), b_addn(), ts_reserve(), pt_unpack(), st_token(), st_vid(), pt_pack()
+ *	Parameters : chunk: PChunk*, the scanned chunks, in source order
+ *				 chunks: size_t, the number of chunks
+ *				 ts: pTokenStream, an empty token stream
+ *				 str_LTBL: pBuffer, an empty string literal table
+ *				 st: pSymbolTable, an empty symbol table
+ *	Return value : 0 on success, 1 if a chunk failed or the results can't grow
+ *	Algorithm : Every chunk but the last one ends with the SEOF_T of its end, which is dropped. The
+ *				offsets are already the source's. Each token is unpacked and packed again with its line and
+ *				string literal offset moved by the chunks before it, and its identifier installed in st, in source order, so the
+ *				symbol indexes and the lexeme table come out as a serial scan makes them.
+ */
+static int ps_join(PChunk* chunk, size_t chunks, pTokenStream ts, pBuffer str_LTBL, pSymbolTable st)
+{
+	size_t total = 0; /* tokens of all the chunks */
+	size_t line_base = 0; /* lines before the chunk */
+	size_t str_base = 0; /* string literal chars before the chunk */
+	size_t str_size; /* string literal chars of the chunk */
+	size_t i, j; /* chunk and token index */
+	size_t count; /* tokens of the chunk that are kept */
+	Token t; /* a token of the chunk */
+	PChunk* pc; /* the chunk */
+
+	for (i = 0; i < chunks; ++i) {
+		if (chunk[i].failed)
+			return 1;
+		total += chunk[i].ts.count;
+	}
+	if (ts_reserve(ts, total) != 0)
+		return 1;
+
+	for (i = 0; i < chunks; ++i) {
+		pc = &chunk[i];
+		count = i + 1 < chunks ? pc->ts.count - 1 : pc->ts.count;
+		for (j = 0; j < count; ++j) {
+			t = pt_unpack(&pc->ts.token[j], &pc->ts.lexemes);
+			if (t.avid_attribute.flags & AV_SYMBOL)
+				st_token(&pc->st, &t);
+			if (t.code == AVID_T || t.code == SVID_T)
+				st_vid(st, &t, pc->ts.line[j] + (int)line_base);	/* as the serial scanner does, a full table is no error */
+			if (t.code == STR_T)
+				t.attribute.str_offset += str_base;
+			if (pt_pack(&t, pc->ts.token[j].offset, pc->ts.token[j].length, &ts->lexemes, &ts->token[ts->count]) != 0)
+				return 1;
+			ts->line[ts->count++] = pc->ts.line[j] + (int)line_base;
+		}
+		line_base += pc->lines;
+		str_size = b_limit(pc->str_LTBL);
+		if (str_size > 0 && b_addn(str_LTBL, b_view(pc->str_LTBL, 0, str_size, NULL), str_size) == NULL)
+			return 1;
+		str_base += str_size;
+	}
+	ts->symbols = st;
+	return 0;
+}
+
+
+/* Number of processors, 1 if it can't be found */
+static int ps_cpus(void) {
+#ifdef _WIN32
+	SYSTEM_INFO si; /* system information */
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN); /* processors online */
+	return n > 0 ? (int)n : 1;
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+/*
+ *	File name: pscan.h
+ *	Compiler: MS Visual Studio 2019 (Windows threads), gcc / clang with -lpthread (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026, revised October 17th, 2026
+ *	Purpose: Declares the parallel scan. The source is cut into chunks at line ends where no string literal or
+ *			 comment is open, worker threads scan the chunks in place through shared cursors and their token
+ *			 streams are joined into the stream a serial scan gives. On POSIX systems the program must be
+ *			 linked with -lpthread.
+ *
+ *	Function list: N/A (no function definitions, only declarations)
+ */
+
+#ifndef PSCAN_H_
+#define PSCAN_H_
+
+#include "buffer.h"
+#include "scanner.h"
+#include "symtab.h"
+
+#define PS_MIN_CHUNK ((size_t)1 << 20)	/* smallest chunk worth a thread, smaller sources are scanned serially */
+#define PS_MAX_THREADS 64				/* most chunks a source is cut into */
+#define PS_STR_CAPACITY 100				/* initial capacity of the string literal table of a chunk */
+
+/* function declarations */
+size_t ps_chunks(size_t n, int threads);
+int malar_scan_parallel(pBuffer sc_buf, pTokenStream ts, pBuffer str_LTBL, pSymbolTable st, int threads);
+
+#endif
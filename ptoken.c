@@ -0,0 +1,255 @@
+/*
+ *	File name: ptoken.c
+ *	Compiler: any C99 compiler: MS Visual Studio 2019, gcc / clang (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026, revised October 17th, 2026
+ *	Purpose: Implements the packed tokens and their lexeme table. Packing a token keeps its code, its place
+ *			 in the source and a 32 bit attribute. The identifier and error text goes to the lexeme table,
+ *			 where equal texts share one entry, so a token stream takes half the memory of Tokens
+ *			 and two tokens of the same identifier have the same value.
+ *
+ *	Function list:  lt_init()
+ *			lt_intern()
+ *			lt_lexeme()
+ *			lt_append()
+ *			lt_free()
+ *			pt_pack()
+ *			pt_unpack()
+ *			lt_hash()
+ *			lt_rehash()
+ */
+
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* strlen(), strcmp(), memcpy() */
+
+#include "ptoken.h"
+#include "symtab.h"
+
+#define LT_FNV_BASIS 2166136261U	/* FNV-1a 32 bit offset basis */
+#define LT_FNV_PRIME 16777619U		/* FNV-1a 32 bit prime */
+
+static unsigned int lt_hash(const char* lexeme);
+static int lt_rehash(pLexTable lt, size_t size);
+
+
+/* Initializes an empty lexeme table, nothing is allocated until the first lexeme is added */
+void lt_init(pLexTable lt) {
+	lt->chars = NULL;
+	lt->slots = NULL;
+	lt->size = lt->count = 0;
+}
+
+
+/*
+ *	Purpose: Finds a lexeme in the table, adding it if it isn't there yet.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_allocate_as(), b_limit(), b_view(), b_addn(), lt_hash(), lt_rehash(), strlen(), strcmp()
+ *	Parameters : lt: pLexTable, an initialized lexeme table
+ *				 lexeme: const char*, a null terminated lexeme
+ *	Return value : unsigned int, the index of the lexeme, the same for every call with an equal lexeme.
+ *				   LT_FAIL if the table can't grow.
+ *	Algorithm : Linear probing over a table kept at most half full. The table is built (or rebuilt after
+ *				lt_append()) from the chars the first time it is needed.
+ */
+unsigned int lt_intern(pLexTable lt, const char* lexeme)
+{
+	size_t slot; /* probed slot */
+	size_t len = strlen(lexeme) + 1; /* chars of the lexeme with its null terminator */
+	size_t offset; /* offset of the new lexeme */
+	const char* base; /* first char of the table */
+
+	if (lt->chars == NULL && (lt->chars = b_allocate_as(LT_INIT_CAPACITY, 100, MULTIPLICATIVE_MODE)) == NULL)
+		return LT_FAIL;
+	if ((lt->count + 1) * 2 > lt->size && lt_rehash(lt, lt->size ? lt->size * 2 : LT_INIT_SLOTS) != 0)
+		return LT_FAIL;
+
+	base = b_view(lt->chars, 0, 0, NULL); /* 0 chars - only the address is needed */
+	for (slot = lt_hash(lexeme) & (lt->size - 1); lt->slots[slot] != 0; slot = (slot + 1) & (lt->size - 1))
+		if (strcmp(base + lt->slots[slot] - 1, lexeme) == 0)
+			return lt->slots[slot] - 1;
+
+	offset = b_limit(lt->chars);
+	if (offset >= LT_FAIL - len || b_addn(lt->chars, lexeme, len) == NULL)
+		return LT_FAIL;
+	lt->slots[slot] = (unsigned int)offset + 1;
+	++lt->count;
+	return (unsigned int)offset;
+}
+
+
+/* Returns the lexeme at index, or an empty string if index isn't one of the table */
+const char* lt_lexeme(pLexTable lt, unsigned int index) {
+	if (lt->chars == NULL || index >= b_limit(lt->chars))
+		return "";
+	return b_view(lt->chars, index, 0, NULL);
+}
+
+
+/* Appends the chars of null terminated lexemes to the table (a table read back from a file), the
+   hash table is rebuilt by the next lt_intern(). Returns NULL on failure */
+pBuffer lt_append(pLexTable lt, const char* chars, size_t n) {
+	if (lt->chars == NULL && (lt->chars = b_allocate_as(LT_INIT_CAPACITY, 100, MULTIPLICATIVE_MODE)) == NULL)
+		return NULL;
+	free(lt->slots);
+	lt->slots = NULL;
+	lt->size = lt->count = 0;
+	return b_addn(lt->chars, chars, n);
+}
+
+
+/* Frees the lexemes and the hash table, the table is left empty */
+void lt_free(pLexTable lt) {
+	b_free(lt->chars);
+	free(lt->slots);
+	lt_init(lt);
+}
+
+
+/*
+ *	Purpose: Packs a token into its 24 byte form.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : lt_intern(), memcpy()
+ *	Parameters : t: const Token*, the token
+ *				 offset: size_t, source offset of the first char of the token
+ *				 length: size_t, number of source chars of the token
+ *				 lt: pLexTable, receives the text of a VID or an error token
+ *				 pt: PackedToken*, receives the packed token
+ *	Return value : 0 on success, 1 if a string literal offset doesn't fit in 32 bits or the lexeme table
+ *				   can't grow
+ *	Algorithm : A VID with a symbol index keeps only the index, its name is in the symbol table.
+ */
+int pt_pack(const Token* t, size_t offset, size_t length, pLexTable lt, PackedToken* pt)
+{
+	pt->code = (unsigned char)t->code;
+	pt->flags = 0;
+	pt->offset = offset;
+	pt->length = length;
+
+	switch (t->code) {
+	case AVID_T: case SVID_T:
+		if (t->avid_attribute.flags & AV_SYMBOL) {
+			pt->flags |= PT_SYMBOL;
+			pt->value = (unsigned int)t->avid_attribute.values.int_value;
+			return 0;
+		}
+		pt->flags |= PT_INTERNED;
+		return (pt->value = lt_intern(lt, t->attribute.vid_lex)) == LT_FAIL;
+	case ERR_T: case RTE_T:
+		pt->flags |= PT_INTERNED;
+		return (pt->value = lt_intern(lt, t->attribute.err_lex)) == LT_FAIL;
+	case FPL_T:
+		memcpy(&pt->value, &t->attribute.flt_value, sizeof(pt->value)); /* the bits of the float */
+		return 0;
+	case STR_T:
+		pt->value = (unsigned int)t->attribute.str_offset;
+		return t->attribute.str_offset > LT_FAIL;
+	default:
+		pt->value = (unsigned int)t->attribute.get_int;
+		return 0;
+	}
+}
+
+
+/*
+ *	Purpose: Unpacks a packed token back into a Token.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : lt_lexeme(), strlen(), memcpy()
+ *	Parameters : pt: const PackedToken*, the packed token
+ *				 lt: pLexTable, the lexeme table it was packed with
+ *	Return value : Token, the token pt_pack() was given. A VID packed with its symbol index only gets the
+ *				   index back, st_token() completes it from the symbol table.
+ *	Algorithm : The text is copied with the limit of its attribute, in case pt comes from a damaged file.
+ */
+Token pt_unpack(const PackedToken* pt, pLexTable lt)
+{
+	Token t = { 0 }; /* unpacked token, all members 0 */
+	const char* lexeme; /* text of an interned token */
+	size_t len; /* chars of the text */
+
+	t.code = pt->code;
+	switch (pt->code) {
+	case AVID_T: case SVID_T:
+		if (pt->flags & PT_SYMBOL) {
+			t.avid_attribute.flags = AV_SYMBOL;
+			t.avid_attribute.values.int_value = (int)pt->value;
+			break;
+		}
+		lexeme = lt_lexeme(lt, pt->value);
+		len = strlen(lexeme);
+		memcpy(t.attribute.vid_lex, lexeme, len > VID_LEN ? VID_LEN : len);
+		break;
+	case ERR_T: case RTE_T:
+		lexeme = lt_lexeme(lt, pt->value);
+		len = strlen(lexeme);
+		memcpy(t.attribute.err_lex, lexeme, len > ERR_LEN ? ERR_LEN : len);
+		break;
+	case FPL_T:
+		memcpy(&t.attribute.flt_value, &pt->value, sizeof(pt->value));
+		break;
+	case STR_T:
+		t.attribute.str_offset = pt->value;
+		break;
+	default:
+		t.attribute.get_int = (int)pt->value;
+	}
+	return t;
+}
+
+
+/* FNV-1a hash of a null terminated lexeme */
+static unsigned int lt_hash(const char* lexeme) {
+	unsigned int hash = LT_FNV_BASIS; /* hash so far */
+	for (; *lexeme; ++lexeme) {
+		hash ^= (unsigned char)*lexeme;
+		hash *= LT_FNV_PRIME;
+	}
+	return hash;
+}
+
+
+/*
+ *	Purpose: Rebuilds the hash table of a lexeme table with another number of slots.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : calloc(), free(), b_limit(), b_view(), lt_hash(), strlen(), strcmp()
+ *	Parameters : lt: pLexTable, the lexeme table
+ *				 size: size_t, the new number of slots, a power of 2
+ *	Return value : 0 on success, 1 if the slots can't be allocated, the old ones are kept then
+ *	Algorithm : Walk the lexemes in the chars (each one ends at its null terminator) once to count them,
+ *				so the new table ends up at most half full, then again to insert each one that isn't
+ *				already in it.
+ */
+static int lt_rehash(pLexTable lt, size_t size)
+{
+	unsigned int* slots; /* new hash table */
+	const char* base = b_view(lt->chars, 0, 0, NULL); /* first char of the table */
+	size_t limit = b_limit(lt->chars); /* chars in the table */
+	size_t offset; /* offset of the lexeme to insert */
+	size_t slot; /* probed slot */
+	size_t count = 0; /* lexemes counted, then inserted */
+
+	for (offset = 0; offset < limit; offset += strlen(base + offset) + 1)
+		++count;
+	while (size < (count + 1) * 2)
+		size *= 2;
+	count = 0;
+	if (size > (size_t)-1 / sizeof(unsigned int) || (slots = (unsigned int*)calloc(size, sizeof(unsigned int))) == NULL)
+		return 1;
+	for (offset = 0; offset < limit; offset += strlen(base + offset) + 1) {
+		for (slot = lt_hash(base + offset) & (size - 1); slots[slot] != 0; slot = (slot + 1) & (size - 1))
+			if (strcmp(base + slots[slot] - 1, base + offset) == 0)
+				break;
+		if (slots[slot] == 0) {
+			slots[slot] = (unsigned int)offset + 1;
+			++count;
+		}
+	}
+	free(lt->slots);
+	lt->slots = slots;
+	lt->size = size;
+	lt->count = count;
+	return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+/*
+ *	File name: ptoken.h
+ *	Compiler: any C99 compiler: MS Visual Studio 2019, gcc / clang (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026, revised October 17th, 2026
+ *	Purpose: Declares the packed token, a 24 byte form of Token for token streams, and the lexeme table
+ *			 that holds the identifier and error text of packed tokens, each distinct text once.
+ *
+ *	Function list: N/A (no function definitions, only declarations)
+ */
+
+#ifndef PTOKEN_H_
+#define PTOKEN_H_
+
+#include <stddef.h> /* size_t */
+
+#include "buffer.h"
+#include "token.h"
+
+#define LT_INIT_CAPACITY 256	/* initial capacity of the lexeme chars, doubles when full */
+#define LT_INIT_SLOTS 64		/* initial size of the lexeme hash table, a power of 2, doubles at half full */
+#define LT_FAIL 0xFFFFFFFFU		/* lt_intern() failure */
+
+/* packed token flags */
+#define PT_INTERNED 0x01	/* value is the index of the token's text in the lexeme table */
+#define PT_SYMBOL 0x02		/* value is the symbol index of a VID, its name is in the symbol table */
+
+/* A token in 24 bytes (16 where size_t is 32 bits). value is the attribute for the attributes that fit in 32
+   bits (the bits of an FPL, a string literal offset), the symbol index of a VID that has one, the lexeme table
+   index of a VID or ERR_T/RTE_T text otherwise. The offset and length take any source the buffer can hold,
+   the lexeme table and the string literal table are limited to 4 GB */
+typedef struct PackedToken {
+	unsigned char code;		/* token code */
+	unsigned char flags;	/* PT_* flags */
+	unsigned int value;		/* attribute or lexeme table index */
+	size_t offset;			/* source offset of the first char of the token */
+	size_t length;			/* number of source chars of the token */
+} PackedToken;
+
+/* interned lexemes, each one null terminated in chars and named by its offset there */
+typedef struct LexTable {
+	pBuffer chars;			/* the lexemes, allocated by the first lt_intern() or lt_append() */
+	unsigned int* slots;	/* open addressing hash table of lexeme offset + 1, 0 marks a free slot */
+	size_t size;			/* number of slots, 0 until the table is built */
+	size_t count;			/* number of lexemes in the hash table */
+} LexTable, * pLexTable;
+
+/* function declarations */
+void lt_init(pLexTable lt);
+unsigned int lt_intern(pLexTable lt, const char* lexeme);
+const char* lt_lexeme(pLexTable lt, unsigned int index);
+pBuffer lt_append(pLexTable lt, const char* chars, size_t n);
+void lt_free(pLexTable lt);
+int pt_pack(const Token* t, size_t offset, size_t length, pLexTable lt, PackedToken* pt);
+Token pt_unpack(const PackedToken* pt, pLexTable lt);
+
+#endif
@@ -4,17 +4,28 @@
  *	Professor:	Sv Ranev
  *	Purpose:	Implements a token-driven and DFA-driven scanner hybrid which is used
  *				to generate Tokens as defined by the PLATYPUS language specification document.
- *	Functions:	scanner_init()
+ *	Functions:	scanner_init_ctx()
+ *			malar_next_token_ctx()
+ *			scanner_free_ctx()
+ *			scanner_init()
  *			malar_next_token()
+ *			malar_next_tokens()
+ *			ts_init()
+ *			ts_free()
+ *			ts_reserve()
+ *			scanner_replay()
+ *			scanner_symbols()
  *			get_next_state()
- *			char_class()
  *			aa_func02()
  *			aa_func03()
  *			aa_func08()
  *			aa_func05()
  *			aa_func10()
  *			aa_func11()
- *			iskeyword()			   
+ *			lex_cstr()
+ *			iskeyword()
+ *			vid_symbol()
+ *			skip_run()			   
  */
 
 
@@ -36,13 +47,58 @@
 #include <assert.h>  /* assert() prototype */
 
 /* project header files */
+#define B_CURSOR  /* inline b_getc() and friends on the compacted input buffer, see buffer.h */
 #include "buffer.h"
 #include "token.h"
+#include "scanner.h"
 #include "table.h"
 
 #define DEBUG  /* for conditional processing */
 #undef  DEBUG
 
+/* SSE2 is part of every x86-64 target (and of x86 builds that ask for it). skip_run() tests 16 chars
+   per step with it, anywhere else it falls back to one char at a time */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>	/* SSE2 intrinsics */
+#define SC_SSE2
+#endif
+
+/* index of the lowest set bit of a non-zero mask and number of set bits of a 16 bit mask */
+#if defined(__GNUC__)
+#define bit_index(m) __builtin_ctz(m)
+#define bit_count(m) __builtin_popcount(m)
+#else
+#define bit_index(m) bit_index16(m)
+#define bit_count(m) bit_count16(m)
+#endif
+
+/* runs of chars skip_run() moves over */
+#define RUN_LINE 0		/* the rest of a line: up to '\r', '\n' or a sentinel */
+#define RUN_STRING 1	/* a string literal body: up to the closing '"' or a sentinel */
+#define RUN_BLANK 2		/* white space and line terminators */
+#define SL_STATE 9		/* DFA state of a string literal body */
+
+/* the DFA interprets the packed transition table tt_table with get_next_state(). define DFA_DIRECT to use
+   the DFA coded directly in dfa.h instead, generated by dfagen from the same tables ("make dfa.h"). it
+   measured no faster on large sources, so it stays optional, e.g. to compare the two */
+/* #define DFA_DIRECT */
+
+/* run before DFA state s reads a char: a string body in a compacted buffer goes straight to the closing '"'
+   or the sentinel, counting the lines on the way */
+#define DFA_ENTER(s) do { \
+	if ((s) == SL_STATE && b_padded(sc_buf)) \
+		sc_buf->getc_offset += skip_run(sc_buf->cb_head + sc_buf->getc_offset, RUN_STRING, &ctx->line); \
+} while (0)
+
+/* reads the next char of a lexeme into c and counts the line terminators, '\r\n' is read as its '\r' */
+#define DFA_GETC() do { \
+	if ((c = b_getc(sc_buf)) == '\r' || c == '\n') { \
+		++ctx->line; \
+		if (c == '\r' && b_getc(sc_buf) != '\n') \
+			b_retract(sc_buf); \
+	} \
+} while (0)
+
 /*	Global objects - variables */
 /*	This buffer is used as a repository for string literals.
 	It is defined in platy_st.c */
@@ -52,37 +108,82 @@ extern int scerrnum;		/* defined in platy_st.c - run-time error number */
 
 
 /* Local(file) global objects - variables */
-static pBuffer lex_buf;		/*pointer to temporary lexeme buffer*/
-static pBuffer sc_buf;		/*pointer to input source buffer*/
+static ScannerContext sc_ctx;	/*context of scanner_init() and malar_next_token(), holds the input and lexeme buffers*/
+static pTokenStream sc_replay;	/* tokens malar_next_token() returns instead of scanning, see scanner_replay() */
+static size_t sc_next;			/* index of the next token of sc_replay */
 /* No other global variable declarations/definitiond are allowed */
 
 
 /* scanner.c static(local) function  prototypes */
-static int char_class(char c);	/* character class function */
+#ifndef DFA_DIRECT
 static int get_next_state(int, char);	/* state machine function	 */
-static int iskeyword(char* kw_lexeme);	/* keywords lookup functuion */
-Token aa_func02(char* lexeme);	/* accepting state: AVID/ KW */
-Token aa_func03(char* lexeme);	/* accepting state: SVID	 */
-Token aa_func08(char* lexeme);	/* accepting state:	FPL		 */
-Token aa_func05(char* lexeme);	/* accepting state: IL		 */
-Token aa_func10(char* lexeme);	/* accepting state: SL		 */
-Token aa_func11(char* lexeme);	/* accepting state: ES		 */
+#endif
+static int iskeyword(const char* kw_lexeme, size_t len);	/* keywords lookup functuion */
+static void vid_symbol(pScannerContext ctx, Token* t);	/* installs a VID in the symbol table */
+static char* lex_cstr(pScannerContext ctx, const char* lexeme, size_t len);	/* null terminated copy of a lexeme */
+static size_t skip_run(const char* p, int run, int* lines);	/* length of a run of chars in a padded buffer */
+#if !defined(__GNUC__)
+static int bit_index16(unsigned int m);	/* lowest set bit */
+static int bit_count16(unsigned int m);	/* set bits */
+#endif
+Token aa_func02(pScannerContext ctx, const char* lexeme, size_t len);	/* accepting state: AVID/ KW */
+Token aa_func03(pScannerContext ctx, const char* lexeme, size_t len);	/* accepting state: SVID	 */
+Token aa_func08(pScannerContext ctx, const char* lexeme, size_t len);	/* accepting state:	FPL		 */
+Token aa_func05(pScannerContext ctx, const char* lexeme, size_t len);	/* accepting state: IL		 */
+Token aa_func10(pScannerContext ctx, const char* lexeme, size_t len);	/* accepting state: SL		 */
+Token aa_func11(pScannerContext ctx, const char* lexeme, size_t len);	/* accepting state: ES		 */
+
+/* non-static function prototypes are in scanner.h */
+
+/* Accepting function (action) callback table (array) definition, declared in table.h */
+PTR_AAF const aa_table[] =
+{ 
+	NULL,
+	NULL,
+	aa_func02,
+	aa_func03,
+	NULL,
+	aa_func05,
+	NULL, 
+	NULL,
+	aa_func08,
+	NULL,
+	aa_func10,
+	aa_func11,
+	aa_func11
+};
+
+
+
+/*Initializes a scanner context, ctx must be zeroed before its first use. it keeps its lexeme buffer and symbol table from one scan to the next */
+int scanner_init_ctx(pScannerContext ctx, pBuffer psc_buf, pBuffer pstr_LTBL) {
+	if (b_isempty(psc_buf)) return EXIT_FAILURE;	/*1*/
+	/* in case the buffer has been read previously */
+	b_rewind(psc_buf);
+	b_clear(pstr_LTBL);
+	ctx->sc_buf = psc_buf;
+	ctx->str_LTBL = pstr_LTBL;
+	ctx->line = 1;
+	ctx->scerrnum = 0;
+	ctx->tok_offset = 0;
+	ctx->end = 0;
+	return EXIT_SUCCESS;	/* 0 */
+}
 
-/* non-static function prototypes */
-int scanner_init(pBuffer psc_buf);
-Token malar_next_token(void);
 
+/*Frees what a scanner context owns, the lexeme buffer. the input buffer and string literal table are the caller's */
+void scanner_free_ctx(pScannerContext ctx) {
+	b_free(ctx->lex_buf);
+	ctx->lex_buf = NULL;
+}
 
 
-/*Initializes scanner */
+/*Initializes the default scanner context with the global string literal table, and ends a replay */
 int scanner_init(pBuffer psc_buf) {
-	if (b_isempty(psc_buf)) return EXIT_FAILURE;	/*1*/
-	/* in case the buffer has been read previously */
-	b_rewind(psc_buf);
-	b_clear(str_LTBL);
-	line = 1;
-	sc_buf = psc_buf;
-	return EXIT_SUCCESS;	/* 0 */
+	int ret = scanner_init_ctx(&sc_ctx, psc_buf, str_LTBL);	/* 0 on success */
+	sc_replay = NULL;
+	line = sc_ctx.line;
+	return ret;
 /*   scerrnum = 0; */		/* no need - global ANSI C */
 }
 
@@ -91,10 +192,10 @@ int scanner_init(pBuffer psc_buf) {
  *				structure once it finds a token pattern which matches a lexeme found
  *				in the stream of input symbols.
  *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
+ *	History / Versions:	1.3 DFA coded directly (dfa.h) with DFA_DIRECT, get_next_state() otherwise
  *	Called functions:	b_getc(), b_retract(), b_eob(), sprintf(), b_mark(), get_next_state(), 
- *						b_getcoffset(), b_allocate(), strcpy(), b_addc(), b_free()
- *	Parameters:		None
+ *						b_getcoffset(), b_limit(), b_allocate(), strcpy(), b_view(), skip_run()
+ *	Parameters:		ctx: pScannerContext, initialized by scanner_init_ctx(). its line and scerrnum are updated.
  *	Return value:	A Token structure with a code identifying the type of token and sometimes an attribute
  *					which stores the value associated with the token.
  *	Algorithm:	First checks if the char is a simple token consisting of just one or a few chars defined
@@ -102,17 +203,31 @@ int scanner_init(pBuffer psc_buf) {
  *				generate one of the following more complex tokens: Keyword, AVID, SVID, IL, FPL, SL, 
  *				or an error if the lexeme doesn't match any valid pattern.
  */
-Token malar_next_token(void)
+Token malar_next_token_ctx(pScannerContext ctx)
 {
 	Token t = { 0 };	/* token to return after pattern recognition. Set all structure members to 0 */
 	unsigned char c;	/* input symbol */
 	int state = 0;		/* initial state of the FSM */
-	short lexstart;		/* start offset of a lexeme in the input char buffer (array) */
-	short lexend;		/* end offset of a lexeme in the input char buffer (array) */
+	size_t lexstart;	/* start offset of a lexeme in the input char buffer (array) */
+	size_t lexend;		/* end offset of a lexeme in the input char buffer (array) */
+	char* lexeme;		/* contiguous view of the lexeme in the input buffer */
+	pBuffer sc_buf = ctx->sc_buf;	/* input buffer, kept in a local for the inline cursor */
+#ifdef DFA_DIRECT
+	int col;			/* column of c in the transition table, for dfa.h */
+#endif
 
 	/* endless loop broken by token returns it will generate a warning */
 	while (1) {
 
+		/* nothing before this point is needed anymore, a stream mode input buffer may discard it.
+			it is also where the token starts if this char isn't white space */
+		ctx->tok_offset = b_mark(sc_buf, b_getcoffset(sc_buf));
+		if (ctx->end != 0 && ctx->tok_offset >= ctx->end) {	/* the end of a part of the source, see malar_scan_parallel() */
+			t.code = SEOF_T;
+			t.attribute.seof = SEOF_0;
+			return t;
+		}
+
 		c = b_getc(sc_buf);		/* read the next char from the input buffer */
 
 		/* begin token driven scanner */
@@ -122,11 +237,14 @@ Token malar_next_token(void)
 		case '\r': case '\n':
 			if (c == '\r' && (c = b_getc(sc_buf)) != '\n') /* if \r\n, consume the \n char as well to avoid double counting newline */
 				b_retract(sc_buf);						   /* if not, retract the other char */
-			++line;
-			continue;
+			++ctx->line;
+			/* fall through - the rest of the blank run is skipped as a whole */
 
 		/* ignore leading white space check and start the next iteration */
 		case ' ': case '\t': case '\v': case '\f':
+			/* a compacted buffer skips the rest of the run (and counts its lines) in one go */
+			if (b_padded(sc_buf))
+				sc_buf->getc_offset += skip_run(sc_buf->cb_head + sc_buf->getc_offset, RUN_BLANK, &ctx->line);
 			continue;
 
 		case '=': /* check the next char for another '=' -- possible equality operator token */
@@ -159,13 +277,15 @@ Token malar_next_token(void)
 		case '!': /* check next token for possible inline comment -- if not, produce an error token, either way ignore the rest of the line */
 			if ((c = b_getc(sc_buf)) == '!') {
 				/* ignore the rest of the line and start next iteration */
+				if (b_padded(sc_buf))
+					sc_buf->getc_offset += skip_run(sc_buf->cb_head + sc_buf->getc_offset, RUN_LINE, NULL);
 				while ((c = b_getc(sc_buf)) != '\r' && c != '\n' && c != SEOF && c != SEOB)
 					;
 				/* end-of-file indicator on this line? (don't retract if sc_buf is at the end of the buffer (SEOB)) */
 				if (c == SEOF || c == SEOB)
 					b_retract(sc_buf);
 				else if (c == '\r' || c == '\n') {
-					++line;
+					++ctx->line;
 					if (c == '\r' && b_getc(sc_buf) != '\n')		/* if '\r\n' consume the \n as well to avoid double counting newline */
 						b_retract(sc_buf);
 				}
@@ -174,14 +294,22 @@ Token malar_next_token(void)
 			/* if the next char is not '!' assume a comment was intended so ignore the rest of the line anyways but return an error token */
 			t.code = ERR_T;
 			sprintf(t.attribute.err_lex, "!%c", c);
+			/* the sentinel right after the '!' is put back as is, the inline b_getc() would run past it into the padding.
+				the same char anywhere before the end of the buffer is part of the line */
+			if ((c == SEOF || c == SEOB) && b_padded(sc_buf) && b_getcoffset(sc_buf) == b_limit(sc_buf)) {
+				b_retract(sc_buf);
+				return t;
+			}
 			/* ignore the rest of the line and return error token */
+			if (b_padded(sc_buf))
+				sc_buf->getc_offset += skip_run(sc_buf->cb_head + sc_buf->getc_offset, RUN_LINE, NULL);
 			while ((c = b_getc(sc_buf)) != '\r' && c != '\n' && c != SEOF && c != SEOB)
 				;
 			/* end-of-file indicator on this line? (don't retract if sc_buf is at the end of the buffer (SEOB)) */
 			if (c == SEOF || c == SEOB)
 				b_retract(sc_buf);
 			else if (c == '\r' || c == '\n') {
-				++line;
+				++ctx->line;
 				if (c == '\r' && b_getc(sc_buf) != '\n')		/* if '\r\n' consume the \n as well to avoid double counting newline */
 					b_retract(sc_buf);
 			}
@@ -259,6 +387,9 @@ Token malar_next_token(void)
 
 		/* source end-of-file/buffer symbols */
 		case SEOF: case SEOB:
+			/* read from the padding past the sentinel? stay on it so every later call returns SEOF_T as well */
+			if (c == SEOB && b_getcoffset(sc_buf) > b_limit(sc_buf))
+				b_retract(sc_buf);
 			t.code = SEOF_T;
 			t.attribute.seof = (c == SEOF) ? SEOF_EOF : SEOF_0;
 			return t;
@@ -269,7 +400,7 @@ Token malar_next_token(void)
 
 		/*************************************************************************************/
 
-		/* begin transition-table driven DFA */
+		/* begin DFA, coded directly from the transition table */
 
 
 		/* set the mark to the current value of getcoffset (-1 to compensate because the offset looks forward)
@@ -277,13 +408,15 @@ Token malar_next_token(void)
 		lexstart = b_mark(sc_buf, b_getcoffset(sc_buf) - 1);
 
 		/* get char from buffer -> change states based on current state and char -> repeat until at an accepting state */
-		for (state = get_next_state(state, c); as_table[state] == NOAS; state = get_next_state(state, (char)c))
-			if ((c = b_getc(sc_buf)) == '\r' || c == '\n') {
-				++line;
-				/* if '\r\n' consume the \n as well to avoid double counting newline */
-				if (c == '\r' && b_getc(sc_buf) != '\n')
-					b_retract(sc_buf);
-			}
+#ifdef DFA_DIRECT
+#include "dfa.h"
+#else
+		for (state = get_next_state(state, c); !(state & TT_ACCEPT); state = get_next_state(state, (char)c)) {
+			DFA_ENTER(state);
+			DFA_GETC();
+		}
+		state &= TT_STATE;
+#endif
 
 		/* retract getc_offset if accepting state allows it */
 		if (as_table[state] == ASWR)
@@ -292,59 +425,200 @@ Token malar_next_token(void)
 		/* lexend is the value of getc_offset once at an accepting state */
 		lexend = b_getcoffset(sc_buf);
 
-		/*  temporary buffer for writing the stream of symbols to. capacity is fixed and 
-			equal to the difference between lexend and lexstart + 1 for the null byte '\0' */
-		if ((lex_buf = b_allocate((lexend - lexstart) + 1, 0, 'f')) == NULL) {
-			scerrnum = ALOC_BUF_FAIL;
+		/*  temporary buffer for the lexemes which aren't contiguous in the input buffer, or need a null byte '\0'.
+			it is allocated for the first lexeme only and then reused, growing to the longest lexeme + 1 */
+		if (ctx->lex_buf == NULL && (ctx->lex_buf = b_allocate_as(LEX_INIT_CAPACITY, 100, MULTIPLICATIVE_MODE)) == NULL) {
+			ctx->scerrnum = ALOC_BUF_FAIL;
 			t.code = RTE_T;
 			strcpy(t.attribute.err_lex, "RUN TIME ERROR: ");
 			return t;
 		}
 
-		/* set getc_offset back to the first symbol */
-		while (b_retract(sc_buf) != lexstart)
-			;
-
-		/* write the lexeme to the lexeme buffer */
-		while (b_getcoffset(sc_buf) != lexend)
-			b_addc(lex_buf, b_getc(sc_buf));
-
-		b_addc(lex_buf, '\0');		/* terminate the lexeme with a null char */
+		/* the lexeme stays where it is in the input buffer, getc_offset can stay at lexend.
+			b_view() only copies it into lex_buf if it straddles two segments of the input buffer */
+		if ((lexeme = b_view(sc_buf, lexstart, lexend - lexstart, ctx->lex_buf)) == NULL) {
+			ctx->scerrnum = ALOC_BUF_FAIL;
+			t.code = RTE_T;
+			strcpy(t.attribute.err_lex, "RUN TIME ERROR: ");
+			return t;
+		}
 
 		/* fetch and then dereference the appropriate pointer to accepting state
-		   function and pass in the lexeme buffer which has the stream of tokens */
-		t = (aa_table[state])(lex_buf->cb_head);
-		b_free(lex_buf);	/* credit to Prof Ranev for this statement */
+		   function and pass in the span of the lexeme */
+		t = (aa_table[state])(ctx, lexeme, lexend - lexstart);
 		return t;			/* return the Token */
 	}
 }
 
 
 /*
- *	Purpose:	Determines the label (int) of the next state according to the DFA.
+ *	Purpose:	Returns the next Token of the source given to scanner_init(), scanned with the default context,
+ *				or the next token of the stream given to scanner_replay(). The globals line and scerrnum follow
+ *				the context (line follows the stream during a replay).
+ *	Author:		Alex Carrozzi
+ *	History / Versions:	1.2 packed replay
+ *	Called functions:	malar_next_token_ctx(), pt_unpack(), st_token()
+ *	Parameters:		None
+ *	Return value:	A Token structure, see malar_next_token_ctx(). A replay returns its last token
+ *					(SEOF_T) again once all of them have been returned.
+ *	Algorithm:	N/A
+ */
+Token malar_next_token(void)
+{
+	Token t = { 0 };	/* the next token */
+	size_t i;			/* index of the replayed token */
+
+	if (sc_replay != NULL) {
+		if (sc_replay->count == 0) {
+			t.code = SEOF_T;
+			return t;
+		}
+		i = sc_next < sc_replay->count ? sc_next++ : sc_replay->count - 1;
+		t = pt_unpack(&sc_replay->token[i], &sc_replay->lexemes);
+		if ((t.avid_attribute.flags & AV_SYMBOL) && sc_replay->symbols != NULL)
+			st_token(sc_replay->symbols, &t);	/* the name and flags come from the symbol */
+		line = sc_replay->line[i];
+		return t;
+	}
+
+	t = malar_next_token_ctx(&sc_ctx);
+	line = sc_ctx.line;
+	if (sc_ctx.scerrnum != 0)
+		scerrnum = sc_ctx.scerrnum;
+	return t;
+}
+
+
+/*Makes malar_next_token() return the tokens of ts, from the first one, instead of scanning. ts must outlive the replay */
+void scanner_replay(pTokenStream ts) {
+	sc_replay = ts;
+	sc_next = 0;
+}
+
+
+/*Makes the default context install the VIDs it scans in st, NULL for none. st is the caller's */
+void scanner_symbols(pSymbolTable st) {
+	sc_ctx.symbols = st;
+}
+
+
+/*
+ *	Purpose:	Scans up to max tokens into a token stream, after the ones it already has.
+ *	Author:		Alex Carrozzi
+ *	History / Versions:	1.0
+ *	Called functions:	malar_next_token_ctx(), ts_reserve(), pt_pack()
+ *	Parameters:		ctx: pScannerContext, initialized by scanner_init_ctx().
+ *					ts: pTokenStream, initialized by ts_init(). the tokens are appended to it.
+ *					max: size_t, the most tokens to scan.
+ *	Return value:	size_t, the number of tokens appended. Fewer than max once the source ends
+ *					(the SEOF_T or RTE_T token is the last one appended) or if the stream can't grow
+ *					or the token can't be packed, then ctx->scerrnum is set to ALOC_BUF_FAIL.
+ *	Algorithm:	Make room for a token before scanning it, so no token is lost when the stream can't grow,
+ *				then pack it with its offset and length and store its line.
+ */
+size_t malar_next_tokens(pScannerContext ctx, pTokenStream ts, size_t max)
+{
+	Token t;		/* the token just scanned */
+	size_t n;		/* tokens appended so far */
+
+	ts->symbols = ctx->symbols;
+	for (n = 0; n < max; ++n) {
+		if (ts->count == ts->capacity && ts_reserve(ts, ts->count + 1) != 0) {
+			ctx->scerrnum = ALOC_BUF_FAIL;
+			break;
+		}
+		t = malar_next_token_ctx(ctx);
+		if (pt_pack(&t, ctx->tok_offset, b_getcoffset(ctx->sc_buf) - ctx->tok_offset, &ts->lexemes, &ts->token[ts->count]) != 0) {
+			ctx->scerrnum = ALOC_BUF_FAIL;
+			break;
+		}
+		ts->line[ts->count] = ctx->line;
+		++ts->count;
+		if (t.code == SEOF_T || t.code == RTE_T) {
+			++n;
+			break;
+		}
+	}
+	return n;
+}
+
+
+/*Initializes an empty token stream, the arrays are allocated by the first malar_next_tokens() */
+void ts_init(pTokenStream ts) {
+	ts->token = NULL;
+	ts->line = NULL;
+	lt_init(&ts->lexemes);
+	ts->symbols = NULL;
+	ts->count = ts->capacity = 0;
+}
+
+
+/*Frees the arrays and the lexeme table of a token stream and leaves it empty */
+void ts_free(pTokenStream ts) {
+	free(ts->token);
+	free(ts->line);
+	lt_free(&ts->lexemes);
+	ts_init(ts);
+}
+
+
+/*
+ *	Purpose:	Makes room for at least n tokens in a token stream.
+ *	Author:		Alex Carrozzi
  *	History / Versions:	1.0
- *	Called functions:	char_class(), assert(), printf(), exit()
- *	Parameters:		state: int, the current state of the lexeme.
+ *	Called functions:	realloc()
+ *	Parameters:		ts: pTokenStream, the stream to grow.
+ *					n: size_t, the number of tokens it must have room for.
+ *	Return value:	0 on success, 1 if an array can't be reallocated. the stream keeps its tokens
+ *					either way, the arrays that did grow stay bigger.
+ *	Algorithm:	Double the capacity (starting from TS_INIT_CAPACITY) until it reaches n.
+ */
+int ts_reserve(pTokenStream ts, size_t n)
+{
+	size_t capacity = ts->capacity ? ts->capacity : TS_INIT_CAPACITY;	/* new capacity */
+	void* p;		/* reallocated array */
+
+	if (n <= ts->capacity)
+		return 0;
+	while (capacity < n && capacity <= (size_t)-1 / 2)
+		capacity *= 2;
+	if (capacity < n || capacity > (size_t)-1 / sizeof(PackedToken))
+		return 1;	/* overflow */
+	if ((p = realloc(ts->token, capacity * sizeof(PackedToken))) == NULL) return 1;
+	ts->token = (PackedToken*)p;
+	if ((p = realloc(ts->line, capacity * sizeof(int))) == NULL) return 1;
+	ts->line = (int*)p;
+	ts->capacity = capacity;
+	return 0;
+}
+
+
+#ifndef DFA_DIRECT
+/*
+ *	Purpose:	Determines the label (int) of the next state according to the DFA.
+ *	History / Versions:	1.1 packed transition table
+ *	Called functions:	assert(), printf(), exit()
+ *	Parameters:		state: int, the current state of the lexeme, one that isn't accepting.
  *					c: char, the most recently read symbol from the input buffer.
- *	Return value:	int, the label (int) of the next state.
- *					if it's an illegal state (IS) the program is aborted with a call to exit().
+ *	Return value:	int, the label (int) of the next state with the TT_ACCEPT and TT_RETRACT flags of tt_table.
+ *					if it's an illegal state (TT_IS) the program is aborted with a call to exit().
  *	Algorithm:	N/A
  */
 int get_next_state(int state, char c)
 {
 	int col;		/* the column index in the TT */
 	int next;		/* the state to transition to next */
-	col = char_class(c);			/* which column in the TT does the symbol fall under? */
-	next = st_table[state][col];	/* index the symbol table to get to the next state */
+	col = cc_table[(unsigned char)c];	/* which column in the TT does the symbol fall under? */
+	next = tt_table[state][col];	/* index the packed transition table to get to the next state */
 
 #ifdef DEBUG
 	printf("Input symbol: %c Row: %d Column: %d Next: %d \n", c, state, col, next);
 #endif
 
-	assert(next != IS);
+	assert(next != TT_IS);
 
 #ifdef DEBUG
-	if (next == IS) {
+	if (next == TT_IS) {
 		printf("Scanner Error: Illegal state:\n");
 		printf("Input symbol: %c Row: %d Column: %d\n", c, state, col);
 		exit(1);
@@ -352,54 +626,38 @@ int get_next_state(int state, char c)
 #endif
 	return next;	/* return token */
 }
+#endif
 
 
-/*
- *	Purpose:	Determines the column position in the Transition Table that the char, c, falls under.
- *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
- *	Called functions:	None
- *	Parameters:		c: char, the most recently read char from the input buffer.
- *	Return value:	the column position (index) of the Transition Table.
- *	Algorithm:	N/A
- */
-int char_class(char c)
-{
-	if (isalpha(c))	return 0;
-	if (c == '0')	return 1;
-	if (isdigit(c))	return 2;
-	if (c == '.')	return 3;
-	if (c == '@')	return 4; 
-	if (c == '"')	return 5;
-	if (c == EOF || c == SEOB) return 6;
-	return 7;	/* other */
-}
 
 
 /*
  *	Purpose:	Accepting state function for arithmetic variable identifers and keywords (AVID / KW).
  *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
- *	Called functions:	iskeyword(), strncpy(), strlen()
- *	Parameters:		lexeme: char*, pointer to the starting address of the lexeme.
+ *	History / Versions:	1.2 symbol table
+ *	Called functions:	iskeyword(), memcpy(), vid_symbol()
+ *	Parameters:		ctx: pScannerContext, the scan the lexeme comes from.
+ *					lexeme: const char*, pointer to the first char of the lexeme, not null terminated.
+ *					len: size_t, the number of chars in the lexeme.
  *	Return value:	A Token struct with it's code and attribute set based on the nature of the lexeme.
  *	Algorithm:	N/A
  */
-Token aa_func02(char* lexeme)
+Token aa_func02(pScannerContext ctx, const char* lexeme, size_t len)
 {
 	Token t = { 0 };	/* token to return after pattern recognition. Set all structure members to 0 */
 	int kw_idx;			/* keyword index, -1 if no match */
 
 	/* check if lexeme is a keyword first */
-	if ((kw_idx = iskeyword(lexeme)) >= 0) {
+	if ((kw_idx = iskeyword(lexeme, len)) >= 0) {
 		t.code = KW_T;
 		t.attribute.kwt_idx = kw_idx;
 		return t;
 	}
 	/* generate AVID token and store the lexeme in the attribute */
 	t.code = AVID_T;
-	strncpy(t.attribute.vid_lex, lexeme, VID_LEN); 
-	t.attribute.vid_lex[strlen(lexeme) > VID_LEN ? VID_LEN : strlen(lexeme)] = '\0';	/* null terminate the string */
+	memcpy(t.attribute.vid_lex, lexeme, len > VID_LEN ? VID_LEN : len);
+	t.attribute.vid_lex[len > VID_LEN ? VID_LEN : len] = '\0';	/* null terminate the string */
+	vid_symbol(ctx, &t);
 	return t;
 }
 
@@ -407,27 +665,30 @@ Token aa_func02(char* lexeme)
 /*
  *	Purpose:	Accepting state function for string variable identifers (SVID).
  *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
- *	Called functions:	strlen(), strncpy(), strcpy()
- *	Parameters:		lexeme: char*, pointer to the starting address of the lexeme.
+ *	History / Versions:	1.2 symbol table
+ *	Called functions:	memcpy(), vid_symbol()
+ *	Parameters:		ctx: pScannerContext, the scan the lexeme comes from.
+ *					lexeme: const char*, pointer to the first char of the lexeme, not null terminated.
+ *					len: size_t, the number of chars in the lexeme.
  *	Return value:	A Token struct with it's code and attribute set based on the nature of the lexeme.
  *	Algorithm:	N/A
  */
-Token aa_func03(char* lexeme)
+Token aa_func03(pScannerContext ctx, const char* lexeme, size_t len)
 {
 	Token t = { 0 };		/* token to return after pattern recognition. Set all structure members to 0 */
-	int len = strlen(lexeme);	/* lexeme length */
 	t.code = SVID_T;	
 
 	/* safely copy lexeme to token attribute appended with an @ symbol */
 	if (len > VID_LEN) {
-		strncpy(t.attribute.vid_lex, lexeme, VID_LEN - 1);		/* copy VID_LEN - 1 chars to attribute */
-		strcpy(t.attribute.vid_lex + (VID_LEN - 1), "@\0");		/* append "@\0" */
+		memcpy(t.attribute.vid_lex, lexeme, VID_LEN - 1);		/* copy VID_LEN - 1 chars to attribute */
+		t.attribute.vid_lex[VID_LEN - 1] = '@';				/* append "@\0" */
+		t.attribute.vid_lex[VID_LEN] = '\0';
 	}
 	else {
-		strcpy(t.attribute.vid_lex, lexeme);	/* copy lexeme (no concern of buffer overflow) */
+		memcpy(t.attribute.vid_lex, lexeme, len);	/* copy lexeme (no concern of buffer overflow) */
 		t.attribute.vid_lex[len] = '\0';		/* null terminate the string */
 	}
+	vid_symbol(ctx, &t);
 	return t; /* return the Token */
 }
 
@@ -435,20 +696,31 @@ Token aa_func03(char* lexeme)
 /*
  *	Purpose:	Accepting state function for floating-point literal (FPL).
  *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
- *	Called functions:	strtod(), aa_func11()
- *	Parameters:		lexeme: char*, pointer to the starting address of the lexeme.
+ *	History / Versions:	1.1 lexeme span
+ *	Called functions:	lex_cstr(), strtod(), aa_func11()
+ *	Parameters:		ctx: pScannerContext, the scan the lexeme comes from.
+ *					lexeme: const char*, pointer to the first char of the lexeme, not null terminated.
+ *					len: size_t, the number of chars in the lexeme.
  *	Return value:	A Token struct with it's fields set based on the nature of the lexeme.
- *	Algorithm:	N/A
+ *	Algorithm:	strtod() needs a string, so this is the one accepting function that copies its lexeme.
  */
-Token aa_func08(char* lexeme)
+Token aa_func08(pScannerContext ctx, const char* lexeme, size_t len)
 {
 	Token t = { 0 };		/* token to return after pattern recognition. Set all structure members to 0 */
-	double dbl = strtod(lexeme, NULL);		/* double representation of the lexeme */
+	char* str;				/* null terminated copy of the lexeme */
+	double dbl;				/* double representation of the lexeme */
+
+	if ((str = lex_cstr(ctx, lexeme, len)) == NULL) {
+		ctx->scerrnum = ALOC_BUF_FAIL;
+		t.code = RTE_T;
+		strcpy(t.attribute.err_lex, "RUN TIME ERROR: ");
+		return t;
+	}
+	dbl = strtod(str, NULL);
 
 	/* generate error token if lexeme fails boundary check */
 	if (dbl != 0.0 && (dbl > FLT_MAX || dbl < FLT_MIN))
-		return (aa_table[ES])(lexeme);		/* call error accepting state function */
+		return (aa_table[ES])(ctx, str, len);		/* call error accepting state function */
 
 	/* generate floating-point token */
 	t.code = FPL_T;
@@ -460,21 +732,27 @@ Token aa_func08(char* lexeme)
 /*
  *	Purpose:	Accepting state function for integer literal (IL).
  *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
- *	Called functions:	strlen(), atol(), aa_func11()
- *	Parameters:		lexeme: char*, pointer to the starting address of the lexeme.
+ *	History / Versions:	1.1 lexeme span
+ *	Called functions:	memcpy(), atol(), aa_func11()
+ *	Parameters:		ctx: pScannerContext, the scan the lexeme comes from.
+ *					lexeme: const char*, pointer to the first char of the lexeme, not null terminated.
+ *					len: size_t, the number of chars in the lexeme.
  *	Return value:	A Token struct with it's fields set based on the nature of the lexeme.
  *	Algorithm:	N/A
  */
-Token aa_func05(char* lexeme)
+Token aa_func05(pScannerContext ctx, const char* lexeme, size_t len)
 {
 	Token t = { 0 };	/* token to return after pattern recognition. Set all structure members to 0 */
-	int len = strlen(lexeme);		/* lexeme length */
-	long lng_lexeme = atol(lexeme); /* long representation of lexeme */
+	char num[INL_LEN + 1];	/* null terminated copy of the lexeme, it is never longer than INL_LEN digits */
+	long lng_lexeme;	/* long representation of lexeme */
 
 	/* generate error token if lexeme fails boundary check */
-	if (len > INL_LEN || lng_lexeme > SHRT_MAX)
-		return (aa_table[ES])(lexeme);		/* call error accepting state function */
+	if (len > INL_LEN)
+		return (aa_table[ES])(ctx, lexeme, len);		/* call error accepting state function */
+	memcpy(num, lexeme, len);
+	num[len] = '\0';
+	if ((lng_lexeme = atol(num)) > SHRT_MAX)
+		return (aa_table[ES])(ctx, lexeme, len);
 
 	/* generate integer literal token */
 	t.code = INL_T;
@@ -486,30 +764,27 @@ Token aa_func05(char* lexeme)
 /*
  *	Purpose:	Accepting state function for string literal (SL).
  *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
- *	Called functions:	b_limit(), strlen(), b_addc()
- *	Parameters:		lexeme: char*, pointer to the starting address of the lexeme.
+ *	History / Versions:	1.1 lexeme span
+ *	Called functions:	b_limit(), b_addn(), b_addc()
+ *	Parameters:		ctx: pScannerContext, the scan the lexeme comes from.
+ *					lexeme: const char*, pointer to the first char of the lexeme, not null terminated.
+ *					len: size_t, the number of chars in the lexeme, both quotation marks included.
  *	Return value:	A Token struct with it's fields set based on the nature of the lexeme.
  *	Algorithm:	N/A
  */
-Token aa_func10(char* lexeme)
+Token aa_func10(pScannerContext ctx, const char* lexeme, size_t len)
 {
 	Token t = { 0 };	/* token to return after pattern recognition. Set all structure members to 0 */
 	t.code = STR_T;
 
-	/* Token attribute int_value is the next availble position to write to in the string literal buffer. 
+	/* Token attribute str_offset is the next availble position to write to in the string literal buffer. 
 		This value is addc_offset which can be retreived with a call to b_limit() */
-	t.attribute.int_value = b_limit(str_LTBL);
-
-	lexeme[strlen(lexeme)-1] = '\0';	/* overwrite closing quotation mark with null char */
+	t.attribute.str_offset = b_limit(ctx->str_LTBL);
 
-	/* the quoation mark at the beginning of the lexeme should be ignored so the lexeme is incremented once before looping */
-	for (++lexeme; *lexeme; b_addc(str_LTBL, *lexeme++))
-		;
-
-	/* full buffer is checked only once, here when the last char is added */
-	if (b_addc(str_LTBL, '\0') == NULL) {
-		scerrnum = STR_BUF_FULL;
+	/* the quotation marks at both ends of the lexeme are not part of the string, copy what's between them in one block
+		and then terminate the string with a null char */
+	if (b_addn(ctx->str_LTBL, lexeme + 1, len - 2) == NULL || b_addc(ctx->str_LTBL, '\0') == NULL) {
+		ctx->scerrnum = STR_BUF_FULL;
 		t.code = RTE_T;
 		strcpy(t.attribute.err_lex, "RUN TIME ERROR: ");
 		return t;
@@ -523,25 +798,26 @@ Token aa_func10(char* lexeme)
 /*
  *	Purpose:	Accepting state for error state -- generates an error token.
  *	Author:		Alex Carrozzi
- *	History / Versions:	1.0
- *	Called functions:	strlen(), strncpy(), strcpy()
- *	Parameters:		lexeme: char*, pointer to the starting address of the lexeme.
+ *	History / Versions:	1.1 lexeme span
+ *	Called functions:	memcpy(), strcpy()
+ *	Parameters:		ctx: pScannerContext, the scan the lexeme comes from.
+ *					lexeme: const char*, pointer to the first char of the lexeme, not null terminated.
+ *					len: size_t, the number of chars in the lexeme.
  *	Return value:	A Token struct with it's fields set based on the nature of the lexeme.
  *	Algorithm:	N/A
  */
-Token aa_func11(char* lexeme)
+Token aa_func11(pScannerContext ctx, const char* lexeme, size_t len)
 {
 	Token t = { 0 };	/* token to return after pattern recognition. Set all structure members to 0 */
 	t.code = ERR_T;		/* set token code to error value */
-	int len = strlen(lexeme);	 /* lexeme length */
 	
 	/* copy lexeme into error token attribute safely */
 	if (len > ERR_LEN) {
-		strncpy(t.attribute.err_lex, lexeme, ERR_LEN-3);		/* copy lexeme to token attribute, leave space for ellipses */
-		strcpy(t.attribute.err_lex + (ERR_LEN-3), "...\0");		/* append ellipses and null terminator */
+		memcpy(t.attribute.err_lex, lexeme, ERR_LEN-3);		/* copy lexeme to token attribute, leave space for ellipses */
+		strcpy(t.attribute.err_lex + (ERR_LEN-3), "...");		/* append ellipses and null terminator */
 	}
 	else {
-		strcpy(t.attribute.err_lex, lexeme);	/* copy lexeme to token attribute (no concern of buffer overflow) */
+		memcpy(t.attribute.err_lex, lexeme, len);	/* copy lexeme to token attribute (no concern of buffer overflow) */
 		t.attribute.err_lex[len] = '\0';		/* append null terminator */
 	}
 	return t;	/* return the Token */
@@ -549,26 +825,152 @@ Token aa_func11(char* lexeme)
 
 
 /*
- *	Purpose:	Determines whether the scanner has found a keyword as defined in the array kw_lookup[].
+ *	Purpose:	Gives a null terminated copy of a lexeme, in the lexeme buffer of the context.
  *	Author:		Alex Carrozzi
  *	History / Versions:	1.0
- *	Called functions:	strcmp()
- *	Parameters:		lexeme:	char*, pointer to the starting address of the lexeme.
+ *	Called functions:	b_clear(), b_addn(), b_addc_as()
+ *	Parameters:		ctx: pScannerContext, the scan the lexeme comes from.
+ *					lexeme: const char*, pointer to the first char of the lexeme, may already be the lexeme buffer.
+ *					len: size_t, the number of chars in the lexeme.
+ *	Return value:	NULL on error, the copy otherwise. It is valid until the next lexeme.
+ *	Algorithm:	A lexeme which b_view() already copied into the lexeme buffer only needs the null char.
+ */
+static char* lex_cstr(pScannerContext ctx, const char* lexeme, size_t len)
+{
+	if (lexeme != ctx->lex_buf->cb_head && (b_clear(ctx->lex_buf), b_addn(ctx->lex_buf, lexeme, len)) == NULL)
+		return NULL;
+	if (b_addc_as(ctx->lex_buf, '\0', MULTIPLICATIVE_MODE) == NULL)
+		return NULL;
+	return ctx->lex_buf->cb_head;
+}
+
+
+/*
+ *	Purpose:	Determines whether the scanner has found a keyword as defined in the array kw_lookup[].
+ *	Author:		Alex Carrozzi
+ *	History / Versions:	1.2 keyword hash
+ *	Called functions:	strlen(), memcmp()
+ *	Parameters:		kw_lexeme: const char*, pointer to the first char of the lexeme, not null terminated.
+ *					len: size_t, the number of chars in the lexeme.
  *	Return value:	the index of the matching keyword in the kw_lookup array.
  *					-1 if no keyword matches the lexeme.
- *	Algorithm:	Simply loops through the array of keywords and compares the string against the lexeme
-				and returns the index if an identical match is found.
+ *	Algorithm:	Lexemes shorter or longer than every keyword are rejected by length. Otherwise the
+				lexeme is hashed with KW_HASH() and only the keyword in that slot of kw_hash (if any)
+				is compared against the lexeme, most identifiers land in an empty slot or fail the
+				length check and never reach memcmp().
+ */
+int iskeyword(const char* kw_lexeme, size_t len)
+{
+	int index;		/* index of the only keyword the lexeme can be */
+	if (len < KW_MIN_LEN || len > KW_MAX_LEN)
+		return -1;
+	index = kw_hash[KW_HASH(kw_lexeme, len)];
+	if (index < 0 || strlen(kw_table[index]) != len || memcmp(kw_lexeme, kw_table[index], len))	 /* memcmp() will return 0 if an exact match is found */
+		return -1;		/* no match */
+	return index;
+}
+
+
+/*
+ *	Purpose:	Installs the name of a VID token in the symbol table of the context and fills in the
+ *				avid_attribute of the token: the flags of its symbol with AV_SYMBOL, and its symbol index.
+ *	Author:		Alex Carrozzi
+ *	History / Versions:	1.0
+ *	Called functions:	st_vid()
+ *	Parameters:		ctx: pScannerContext, the scan, nothing is done if it has no symbol table.
+ *					t: Token*, an AVID_T or SVID_T token with its vid_lex set.
+ *	Return value:	None
+ *	Algorithm:	A name that can't be installed (the table is full or can't grow) leaves the token as it was,
+ *				it still has its vid_lex.
  */
-int iskeyword(char* kw_lexeme)
+void vid_symbol(pScannerContext ctx, Token* t)
 {
-	int index;		/* index of keyword in kw_table, also used as loop control */
-	for (index = 0; index < KWT_SIZE; ++index)
-		if (!strcmp(kw_lexeme, kw_table[index]))	 /* strcmp() will return 0 if an exact match is found */
-			return index;
+	if (ctx->symbols != NULL)
+		st_vid(ctx->symbols, t, ctx->line);
+}
 
-	return -1;		/* no match */
+
+/*
+ *	Purpose:	Measures a run of chars of a compacted (padded) buffer without going through b_getc(),
+ *				and counts the line terminators in it.
+ *	Author:		Alex Carrozzi
+ *	History / Versions:	1.0
+ *	Called functions:	_mm_loadu_si128(), _mm_set1_epi8(), _mm_cmpeq_epi8(), _mm_or_si128(),
+ *						_mm_movemask_epi8(), bit_index(), bit_count()
+ *	Parameters:		p: const char*, the first char of the run, in a buffer whose sentinel is followed by SENTINEL_PAD
+ *						zeroed bytes.
+ *					run: int, RUN_LINE, RUN_STRING or RUN_BLANK, the chars that end the run (see their definitions).
+ *					lines: int*, incremented by the number of lines the run ends, NULL if not wanted.
+ *	Return value:	size_t, the number of chars before the one that ends the run.
+ *	Algorithm:	With SSE2, compare 16 chars at a time against the chars that end the run and against '\r' and '\n'.
+ *				The lowest bit of the stop mask is the end of the run. A '\r' ends a line, a '\n' ends one unless the
+ *				char before it is a '\r', so a "\r\n" is counted once as in malar_next_token_ctx(). Every run stops
+ *				on a sentinel or on the zeroed padding, so no load goes further than 16 chars past the sentinel.
+ *				Without SSE2 the same test is done one char at a time.
+ */
+size_t skip_run(const char* p, int run, int* lines)
+{
+	size_t n = 0;		/* chars of the run so far */
+	unsigned int cr = 0;	/* 1 if the char before p[n] is a '\r' in the run */
+#ifdef SC_SSE2
+	__m128i v;			/* 16 chars of the run */
+	unsigned int r;		/* '\r' positions in v */
+	unsigned int nl;	/* '\n' positions in v */
+	unsigned int stop;	/* positions of the chars that end the run */
+	unsigned int in;	/* positions in v that are part of the run */
+
+	for (;; n += 16) {
+		v = _mm_loadu_si128((const __m128i*)(p + n));
+		r = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+		nl = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+		if (run == RUN_BLANK)
+			stop = ~(r | nl | (unsigned int)_mm_movemask_epi8(_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\v')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\f')))))) & 0xFFFF;
+		else
+			stop = (run == RUN_LINE ? r | nl : (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))
+				| (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)SEOB)),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8((char)SEOF))));
+		in = stop ? (stop & (0u - stop)) - 1 : 0xFFFF;	/* the bits below the lowest stop bit */
+		if (lines)
+			*lines += bit_count(r & in) + bit_count(nl & in & ~((r << 1) | cr));
+		if (stop)
+			return n + bit_index(stop);
+		cr = r >> 15;
+	}
+#else
+	unsigned char c;	/* current char */
+
+	for (;; ++n) {
+		c = (unsigned char)p[n];
+		if (run == RUN_BLANK ? c != ' ' && c != '\t' && c != '\v' && c != '\f' && c != '\r' && c != '\n'
+			: c == SEOB || c == SEOF || (run == RUN_LINE ? c == '\r' || c == '\n' : c == '"'))
+			return n;
+		if (lines && (c == '\r' || (c == '\n' && !cr)))
+			++*lines;
+		cr = (c == '\r');
+	}
+#endif
 }
 
 
+#if !defined(__GNUC__)
+/*Index of the lowest set bit of a non-zero mask */
+int bit_index16(unsigned int m) {
+	int i = 0;	/* bit index */
+	while (!(m & 1)) {
+		m >>= 1;
+		++i;
+	}
+	return i;
+}
 
 
+/*Number of set bits in a 16 bit mask */
+int bit_count16(unsigned int m) {
+	m = m - ((m >> 1) & 0x5555);
+	m = (m & 0x3333) + ((m >> 2) & 0x3333);
+	m = (m + (m >> 4)) & 0x0F0F;
+	return (int)((m + (m >> 8)) & 0x1F);
+}
+#endif
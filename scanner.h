@@ -0,0 +1,62 @@
+/*	File name:	scanner.h
+ *	Compiler:	MS Visual Studio 2019
+ *	Author:		Alex Carrozzi
+ *	Date:		October 16th, 2026
+ *	Purpose:	Provides the scanner context, which holds the state of one scan: the input buffer,
+ *				the lexeme buffer, the string literal table, the line number and the run-time error number.
+ *				Each context can scan its own source at the same time as the others, one thread per context.
+ *				scanner_init() and malar_next_token() scan with a default context kept in scanner.c.
+ *				malar_next_tokens() scans a batch of tokens into a TokenStream, and scanner_replay() makes
+ *				malar_next_token() return the tokens of a stream instead of scanning.
+ *				A context with a symbol table installs every VID it scans there and fills the avid_attribute
+ *				of the token with its symbol index and flags.
+ *	Functions:	Only declarations
+ */
+
+#ifndef SCANNER_H_
+#define SCANNER_H_
+
+#include "buffer.h"
+#include "token.h"
+#include "ptoken.h"
+#include "symtab.h"
+
+/* state of one scan */
+typedef struct ScannerContext {
+	pBuffer sc_buf;		/* input source buffer, owned by the caller */
+	pBuffer lex_buf;	/* temporary lexeme buffer, reused for every lexeme, freed by scanner_free_ctx() */
+	pBuffer str_LTBL;	/* string literal table, owned by the caller */
+	int line;			/* current line number of the source code */
+	int scerrnum;		/* run-time error number, 0 if none */
+	size_t tok_offset;	/* input buffer offset of the first char of the last token */
+	size_t end;			/* offset where a token starting there is scanned as SEOF_T, 0 to scan up to the sentinel */
+	pSymbolTable symbols;	/* symbol table of the VIDs, owned by the caller, NULL for none */
+} ScannerContext, * pScannerContext;
+
+#define TS_INIT_CAPACITY 256	/* tokens a stream makes room for the first time, it doubles when full */
+
+/* tokens scanned in batches, packed into 24 bytes each with their text in a lexeme table.
+   the lines are kept apart since few passes need them. token i is token[i] and line[i] */
+typedef struct TokenStream {
+	PackedToken* token;	/* the packed tokens */
+	int* line;			/* source line of each token */
+	LexTable lexemes;	/* identifier and error text of the tokens */
+	pSymbolTable symbols;	/* symbol table the VID tokens refer to (the one of the scanning context), NULL for none */
+	size_t count;		/* tokens in the stream */
+	size_t capacity;	/* tokens the arrays have room for */
+} TokenStream, * pTokenStream;
+
+/* function declarations */
+int scanner_init_ctx(pScannerContext ctx, pBuffer psc_buf, pBuffer pstr_LTBL);
+Token malar_next_token_ctx(pScannerContext ctx);
+void scanner_free_ctx(pScannerContext ctx);
+int scanner_init(pBuffer psc_buf);
+Token malar_next_token(void);
+size_t malar_next_tokens(pScannerContext ctx, pTokenStream ts, size_t max);
+void scanner_replay(pTokenStream ts);
+void scanner_symbols(pSymbolTable st);
+void ts_init(pTokenStream ts);
+int ts_reserve(pTokenStream ts, size_t n);
+void ts_free(pTokenStream ts);
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ *	File name: symtab.c
+ *	Compiler: any C99 compiler: MS Visual Studio 2019, gcc / clang (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026
+ *	Purpose: Implements the symbol table. The names go to a lexeme table, so a name seen again costs a hash
+ *			 lookup and no memory, and two tokens of the same variable carry the same symbol index.
+ *
+ *	Function list:  st_init()
+ *			st_install()
+ *			st_name()
+ *			st_token()
+ *			st_vid()
+ *			st_reserve()
+ *			st_free()
+ */
+
+#include <stdlib.h> /* realloc(), free() */
+#include <string.h> /* strlen(), memcpy() */
+
+#include "symtab.h"
+
+
+/* Initializes an empty symbol table, nothing is allocated until the first symbol is installed */
+void st_init(pSymbolTable st) {
+	lt_init(&st->names);
+	st->records = NULL;
+	st->count = st->capacity = 0;
+}
+
+
+/*
+ *	Purpose: Finds the symbol of a variable name, installing it the first time the name is seen.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_limit(), lt_intern(), st_reserve()
+ *	Parameters : st: pSymbolTable, an initialized symbol table
+ *				 name: const char*, the null terminated name, as in the vid_lex of its token
+ *				 code: int, AVID_T or SVID_T
+ *				 line: int, the source line of the name
+ *	Return value : int, the symbol index, the same for every occurrence of the name.
+ *				   ST_FAIL if the table can't grow or already has ST_MAX_SYMBOLS symbols.
+ *	Algorithm : A name that lt_intern() adds at the end of the name table is new, its record goes at the
+ *				end too. The type of an SVID is string, an AVID is an integer if its name starts with
+ *				i, o, d or w and floating-point otherwise. Any other name is found by a binary search of
+ *				the records on its name index.
+ */
+int st_install(pSymbolTable st, const char* name, int code, int line)
+{
+	size_t limit = st->names.chars ? b_limit(st->names.chars) : 0; /* where a new name goes */
+	unsigned int index; /* index of the name in the name table */
+	size_t lo = 0, hi = st->count; /* records left to search */
+	size_t mid; /* record compared */
+	SymbolRecord* rec; /* the new record */
+
+	if ((index = lt_intern(&st->names, name)) == LT_FAIL)
+		return ST_FAIL;
+	if (index != limit) {
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (st->records[mid].name < index)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo < st->count && st->records[lo].name == index ? (int)lo : ST_FAIL;
+	}
+
+	/* a new name - it stays in the name table even if it gets no record, it is then not found above */
+	if (st->count >= ST_MAX_SYMBOLS || st_reserve(st, st->count + 1) != 0)
+		return ST_FAIL;
+	rec = &st->records[st->count];
+	memset(rec, 0, sizeof(*rec));
+	rec->name = index;
+	rec->line = line;
+	if (code == SVID_T)
+		rec->attr.flags = AV_STRING;
+	else if (*name == 'i' || *name == 'o' || *name == 'd' || *name == 'w')
+		rec->attr.flags = AV_INT;
+	else
+		rec->attr.flags = AV_FLOAT;
+	return (int)st->count++;
+}
+
+
+/* Returns the name of a symbol, an empty string if index isn't one of the table */
+const char* st_name(pSymbolTable st, int index) {
+	if (index < 0 || (size_t)index >= st->count)
+		return "";
+	return lt_lexeme(&st->names, st->records[index].name);
+}
+
+
+/*
+ *	Purpose: Completes a VID token that only has its symbol index (a token unpacked from a token stream):
+ *			 copies in its name and the flags of its symbol.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : st_name(), strlen(), memcpy()
+ *	Parameters : st: pSymbolTable, the symbol table the index comes from
+ *				 t: Token*, an AVID_T or SVID_T token with AV_SYMBOL set
+ *	Return value : 0 on success, 1 if the token has no symbol index of the table
+ *	Algorithm : N/A
+ */
+int st_token(pSymbolTable st, Token* t)
+{
+	int index = t->avid_attribute.values.int_value; /* symbol index */
+	const char* name; /* name of the symbol */
+	size_t len; /* chars of the name */
+
+	if (!(t->avid_attribute.flags & AV_SYMBOL) || index < 0 || (size_t)index >= st->count)
+		return 1;
+	name = st_name(st, index);
+	len = strlen(name);
+	len = len > VID_LEN ? VID_LEN : len;
+	memcpy(t->attribute.vid_lex, name, len);
+	t->attribute.vid_lex[len] = '\0';
+	t->avid_attribute.flags = (unsigned char)(st->records[index].attr.flags | AV_SYMBOL);
+	return 0;
+}
+
+
+/*
+ *	Purpose: Installs the name of a VID token and fills in the avid_attribute of the token: the flags of
+ *			 its symbol with AV_SYMBOL, and its symbol index.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : st_install()
+ *	Parameters : st: pSymbolTable, the symbol table
+ *				 t: Token*, an AVID_T or SVID_T token with its vid_lex set
+ *				 line: int, the source line of the token
+ *	Return value : 0 on success, 1 if the name can't be installed (the table is full or can't grow), the
+ *				   token is left as it was then, it still has its vid_lex
+ *	Algorithm : N/A
+ */
+int st_vid(pSymbolTable st, Token* t, int line)
+{
+	int index; /* symbol index */
+
+	if ((index = st_install(st, t->attribute.vid_lex, t->code, line)) == ST_FAIL)
+		return 1;
+	t->avid_attribute = st->records[index].attr;
+	t->avid_attribute.flags |= AV_SYMBOL;
+	t->avid_attribute.values.int_value = index;
+	return 0;
+}
+
+
+/* Makes room for at least n records, doubling from ST_INIT_CAPACITY. Returns 0 on success, 1 if they can't be allocated */
+int st_reserve(pSymbolTable st, size_t n) {
+	size_t capacity = st->capacity ? st->capacity : ST_INIT_CAPACITY; /* new capacity */
+	SymbolRecord* records; /* reallocated records */
+
+	if (n <= st->capacity)
+		return 0;
+	while (capacity < n)
+		capacity *= 2;
+	if (capacity > (size_t)-1 / sizeof(SymbolRecord)
+		|| (records = (SymbolRecord*)realloc(st->records, capacity * sizeof(SymbolRecord))) == NULL)
+		return 1;
+	st->records = records;
+	st->capacity = capacity;
+	return 0;
+}
+
+
+/* Frees the names and the records, the table is left empty */
+void st_free(pSymbolTable st) {
+	lt_free(&st->names);
+	free(st->records);
+	st_init(st);
+}
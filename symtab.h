@@ -0,0 +1,60 @@
+#pragma once
+/*
+ *	File name: symtab.h
+ *	Compiler: any C99 compiler: MS Visual Studio 2019, gcc / clang (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026
+ *	Purpose: Declares the symbol table the scanner fills with the variable identifiers (AVID and SVID) it
+ *			 finds. Each name is interned once and gets a symbol index, which the scanner puts in the
+ *			 avid_attribute of every token of that name along with the type and value flags.
+ *
+ *	Function list: N/A (no function definitions, only declarations)
+ */
+
+#ifndef SYMTAB_H_
+#define SYMTAB_H_
+
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* size_t */
+
+#include "token.h"
+#include "ptoken.h"
+
+#define ST_INIT_CAPACITY 64	/* initial number of records, doubles when full */
+#define ST_MAX_SYMBOLS INT_MAX	/* the index is kept in avid_attribute.values.int_value, an int */
+#define ST_FAIL (-1)		/* st_install() failure */
+
+/* avid_attribute.flags of a VID token and of its symbol */
+#define AV_TYPE 0x03	/* type bits */
+#define AV_FLOAT 0x01	/* floating-point AVID, the default type of an AVID */
+#define AV_INT 0x02		/* integer AVID, an AVID whose name starts with i, o, d or w */
+#define AV_STRING 0x03	/* SVID */
+#define AV_VALUE 0x04	/* the variable has been given a value, left for later passes, the scanner never sets it */
+#define AV_SYMBOL 0x08	/* the token's avid_attribute.values.int_value is its symbol index */
+
+/* one variable: its name, where it first appears, its type and value flags and its initial value */
+typedef struct SymbolRecord {
+	unsigned int name;	/* index of the name in the name table */
+	int line;			/* line of the first occurrence */
+	AVIDTA attr;		/* type and value flags, initial value: 0, 0.0 or no string */
+} SymbolRecord;
+
+/* the variables of a source, indexed by symbol index. The records are in the order of their names in
+   the name table, so the record of a name is found by a binary search on its index */
+typedef struct SymbolTable {
+	LexTable names;			/* interned names */
+	SymbolRecord* records;	/* the symbols */
+	size_t count;			/* number of symbols */
+	size_t capacity;		/* records allocated */
+} SymbolTable, * pSymbolTable;
+
+/* function declarations */
+void st_init(pSymbolTable st);
+int st_install(pSymbolTable st, const char* name, int code, int line);
+const char* st_name(pSymbolTable st, int index);
+int st_token(pSymbolTable st, Token* t);
+int st_vid(pSymbolTable st, Token* t, int line);
+int st_reserve(pSymbolTable st, size_t n);
+void st_free(pSymbolTable st);
+
+#endif
@@ -0,0 +1,119 @@
+/*	File name:	table.c
+ *	Compiler:	MS Visual Studio 2019, gcc / clang (Makefile)
+ *	Author:		Alex Carrozzi
+ *	Date:		October 16th, 2026, revised October 17th, 2026
+ *	Purpose:	Defines the tables of the Deterministic Finite Automata for the PLATYPUS language declared
+ *				in table.h: character classes, transitions, packed transitions, accepting states and keywords.
+ *				They are const and defined here only, once for the whole program. The accepting functions
+ *				and their table aa_table are scanner.c's, so the tables here can be linked on their own.
+ *	Functions:	None
+ */
+
+#include "table.h"
+
+/* character class table - the column of the transition table for each of the 256 byte values.
+   letters are the ASCII letters of the "C" locale, SEOB (0) and SEOF (255) share the SEOF column */
+const unsigned char cc_table[256] = {
+	/*   0 */  6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/*  16 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/*  32 */  7, 7, 5, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 3, 7,
+	/*  48 */  1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 7, 7, 7, 7, 7, 7,
+	/*  64 */  4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/*  80 */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 7, 7, 7, 7,
+	/*  96 */  7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* 112 */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 7, 7, 7, 7,
+	/* 128 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/* 144 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/* 160 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/* 176 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/* 192 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/* 208 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/* 224 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	/* 240 */  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 6
+};
+
+/* transition table - type of states defined in separate table */
+const int st_table[][TABLE_COLUMNS] = {
+	/* State 0  */  {1, 6, 4, ES, ES, 9, ES, ES},
+	/* State 1  */  {1, 1, 1, 2, 3, 2, 2, 2},
+	/* State 2  */  {IS, IS, IS, IS, IS, IS, IS, IS},
+	/* State 3  */  {IS, IS, IS, IS, IS, IS, IS, IS},
+	/* State 4  */  {ES, 4, 4, 7, 5, 5, 5, 5},
+	/* State 5  */  {IS, IS, IS, IS, IS, IS, IS, IS},
+	/* State 6  */  {ES, 6, ES, 7, ES, 5, 5, 5},
+	/* State 7  */  {8, 7, 7, 8, 8, 8, 8, 8},
+	/* State 8  */  {IS, IS, IS, IS, IS, IS, IS, IS},
+	/* State 9  */  {9, 9, 9, 9, 9, 10, ER, 9},
+	/* State 10 */  {IS, IS, IS, IS, IS, IS, IS, IS},
+	/* State 11 */  {IS, IS, IS, IS, IS, IS, IS, IS},
+	/* State 12 */  {IS, IS, IS, IS, IS, IS, IS, IS},
+};
+
+
+/* packed transition table - st_table with the as_table flags of the next state, see table.h.
+   0x8B is ES, 0xCC is ER, TT_IS fills the rows of the accepting states */
+const unsigned char tt_table[][TABLE_COLUMNS] = {
+	/* State 0  */  {0x01, 0x06, 0x04, 0x8B, 0x8B, 0x09, 0x8B, 0x8B},
+	/* State 1  */  {0x01, 0x01, 0x01, 0xC2, 0x83, 0xC2, 0xC2, 0xC2},
+	/* State 2  */  {TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS},
+	/* State 3  */  {TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS},
+	/* State 4  */  {0x8B, 0x04, 0x04, 0x07, 0xC5, 0xC5, 0xC5, 0xC5},
+	/* State 5  */  {TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS},
+	/* State 6  */  {0x8B, 0x06, 0x8B, 0x07, 0x8B, 0xC5, 0xC5, 0xC5},
+	/* State 7  */  {0xC8, 0x07, 0x07, 0xC8, 0xC8, 0xC8, 0xC8, 0xC8},
+	/* State 8  */  {TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS},
+	/* State 9  */  {0x09, 0x09, 0x09, 0x09, 0x09, 0x8A, 0xCC, 0x09},
+	/* State 10 */  {TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS},
+	/* State 11 */  {TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS},
+	/* State 12 */  {TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS, TT_IS},
+};
+
+
+/* Accepting state table definition */
+const int as_table[] =
+{	
+	NOAS,	/* State 0  */
+	NOAS,	/* State 1  */
+	ASWR,	/* State 2  */
+	ASNR,	/* State 3  */
+	NOAS,	/* State 4  */
+	ASWR,	/* State 5  */
+	NOAS,	/* State 6  */
+	NOAS,	/* State 7  */
+	ASWR,	/* State 8  */
+	NOAS,	/* State 9  */
+	ASNR,	/* State 10 */
+	ASNR,	/* State 11 */
+	ASWR	/* State 12 */
+};
+
+
+/* Keyword lookup table */
+const char* const kw_table[] =
+{
+	"ELSE",
+	"FALSE",
+	"IF",
+	"PLATYPUS",
+	"READ",
+	"REPEAT",
+	"THEN",
+	"TRUE",
+	"WHILE",
+	"WRITE"
+};
+
+/* Keyword hash table - the kw_table index of the keyword that KW_HASH() maps to each slot, -1 for an empty slot.
+   KW_HASH() has no collisions over kw_table, so a lexeme can only be the keyword in its slot.
+   If kw_table changes the table has to be rebuilt (and KW_HASH() retuned if two keywords collide) */
+const signed char kw_hash[KWH_SIZE] =
+{
+/*	 0		 1		 2		 3		 4		 5		 6		 7	*/
+	 7,		-1,		-1,		 2,		 9,		-1,		-1,		-1,
+/*	 8		 9		10		11		12		13		14		15	*/
+	 3,		-1,		 4,		-1,		 5,		-1,		-1,		 1,
+/*	16		17		18		19		20		21		22		23	*/
+	-1,		-1,		-1,		-1,		-1,		-1,		-1,		-1,
+/*	24		25		26		27		28		29		30		31	*/
+	 6,		 0,		-1,		-1,		 8,		-1,		-1,		-1
+};
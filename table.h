@@ -6,10 +6,11 @@
  *	Assignment:	2
  *	Date:		November 2, 2019
  *	Professor:	Sv Ranev
- *	Purpose:	Defines the Deterministic Finite Automata for the PLATYPUS language.
+ *	Purpose:	Declares the Deterministic Finite Automata for the PLATYPUS language.
  *				The DFA is defined the following tables: transition table, the accepting state 
  *				of each state, pointers to accepting state, as well as the declarations 
- *				of the those pointers. An addition keyword lookup table is defined here.
+ *				of the those pointers. An addition keyword lookup table is declared here.
+ *				The tables are const and defined once, in table.c.
  *	Functions:	The following are all declarations:
  *				aa_func02()
  *				aa_func03()
@@ -26,19 +27,28 @@
 #include "buffer.h"
 #endif
 
+#include "scanner.h" /* ScannerContext, passed to the accepting functions */
+
 #ifndef NULL
 #include <_null.h> /* NULL pointer constant is defined there */
 #endif
 
 #define KWT_SIZE 10		/* keywords in the PLATYPUS language  */
+#define KW_MIN_LEN 2	/* shortest keyword (IF) */
+#define KW_MAX_LEN 8	/* longest keyword (PLATYPUS) */
+#define KWH_SIZE 32		/* slots in the keyword hash table, a power of 2 */
+#define KW_HASH(s, len) (((len) + (unsigned char)(s)[0] + ((unsigned char)(s)[1] << 2)) & (KWH_SIZE - 1))	/* keyword hash, needs len >= 2 */
 #define ALOC_BUF_FAIL 1	/* call to b_allocate() failed (returned NULL) */
 #define STR_BUF_FULL 2	/* string literal buffer full -- can't add the lexeme */
+
+#define LEX_INIT_CAPACITY 64	/* initial capacity of the lexeme buffer, it doubles whenever a longer lexeme comes along */
 #define SEOF 255		/* Source end-of-filesentinel symbol */
 #define SEOB 0			/* Source end-of-buffer symbolic constant */
 #define ES 11			/* Error state  with no retract */
 #define ER 12			/* Error state  with retract */
 #define IS -1			/* Invalid state */
 
+#define TABLE_ROWS 13		/* transition table row count, the states of the DFA */
 #define TABLE_COLUMNS 8		/* transition table column count */
  /*	Column Headers
 
@@ -51,22 +61,20 @@
 	Index 6:	SEOF
 	Index 7:	other
 */
+/* character class table - the column of the transition table for each of the 256 byte values */
+extern const unsigned char cc_table[256];
+
 /* transition table - type of states defined in separate table */
-int  st_table[][TABLE_COLUMNS] = {
-	/* State 0  */  {1, 6, 4, ES, ES, 9, ES, ES},
-	/* State 1  */  {1, 1, 1, 2, 3, 2, 2, 2},
-	/* State 2  */  {IS, IS, IS, IS, IS, IS, IS, IS},
-	/* State 3  */  {IS, IS, IS, IS, IS, IS, IS, IS},
-	/* State 4  */  {ES, 4, 4, 7, 5, 5, 5, 5},
-	/* State 5  */  {IS, IS, IS, IS, IS, IS, IS, IS},
-	/* State 6  */  {ES, 6, ES, 7, ES, 5, 5, 5},
-	/* State 7  */  {8, 7, 7, 8, 8, 8, 8, 8},
-	/* State 8  */  {IS, IS, IS, IS, IS, IS, IS, IS},
-	/* State 9  */  {9, 9, 9, 9, 9, 10, ER, 9},
-	/* State 10 */  {IS, IS, IS, IS, IS, IS, IS, IS},
-	/* State 11 */  {IS, IS, IS, IS, IS, IS, IS, IS},
-	/* State 12 */  {IS, IS, IS, IS, IS, IS, IS, IS},
-};
+extern const int st_table[TABLE_ROWS][TABLE_COLUMNS];
+
+/* packed transition table - st_table and as_table in one byte per transition: the next state in the low bits,
+   TT_ACCEPT if it is an accepting state and TT_RETRACT if it is one with retract. A state that isn't accepting
+   is its own code, so the DFA loop does one lookup and one test per char. 13 rows of 8 bytes, two cache lines */
+#define TT_STATE 0x0F	/* next state bits */
+#define TT_RETRACT 0x40	/* accepting state with retract */
+#define TT_ACCEPT 0x80	/* accepting state */
+#define TT_IS 0x0F		/* invalid state */
+extern const unsigned char tt_table[TABLE_ROWS][TABLE_COLUMNS];
 
 
 /* Accepting state table definition */
@@ -74,70 +82,32 @@ int  st_table[][TABLE_COLUMNS] = {
 #define ASNR 2		/* accepting state with no retract */
 #define NOAS 0		/* not accepting state */
 
-int as_table[] = 
-{	
-	NOAS,	/* State 0  */
-	NOAS,	/* State 1  */
-	ASWR,	/* State 2  */
-	ASNR,	/* State 3  */
-	NOAS,	/* State 4  */
-	ASWR,	/* State 5  */
-	NOAS,	/* State 6  */
-	NOAS,	/* State 7  */
-	ASWR,	/* State 8  */
-	NOAS,	/* State 9  */
-	ASNR,	/* State 10 */
-	ASNR,	/* State 11 */
-	ASWR	/* State 12 */
-};
+extern const int as_table[TABLE_ROWS];
 
 
 /* Accepting State Function Prototypes */
-Token aa_func02(char* lexeme);
-Token aa_func03(char* lexeme);
-Token aa_func08(char* lexeme);
-Token aa_func05(char* lexeme);
-Token aa_func10(char* lexeme);
-Token aa_func11(char* lexeme);
-
-
-/* Defining a new type: pointer to function (of one char * argument) returning Token */
-typedef Token (*PTR_AAF)(char* lexeme);
-
-
-/* Accepting function (action) callback table (array) definition */
-PTR_AAF aa_table[] = 
-{ 
-	NULL,
-	NULL,
-	aa_func02,
-	aa_func03,
-	NULL,
-	aa_func05,
-	NULL, 
-	NULL,
-	aa_func08,
-	NULL,
-	aa_func10,
-	aa_func11,
-	aa_func11
-};
+Token aa_func02(pScannerContext ctx, const char* lexeme, size_t len);
+Token aa_func03(pScannerContext ctx, const char* lexeme, size_t len);
+Token aa_func08(pScannerContext ctx, const char* lexeme, size_t len);
+Token aa_func05(pScannerContext ctx, const char* lexeme, size_t len);
+Token aa_func10(pScannerContext ctx, const char* lexeme, size_t len);
+Token aa_func11(pScannerContext ctx, const char* lexeme, size_t len);
+
+
+/* Defining a new type: pointer to function (of a scanner context and the span of the lexeme) returning Token.
+   the lexeme is not null terminated, it usually points straight into the input buffer */
+typedef Token (*PTR_AAF)(pScannerContext ctx, const char* lexeme, size_t len);
+
+
+/* Accepting function (action) callback table (array), defined in scanner.c with the functions */
+extern PTR_AAF const aa_table[TABLE_ROWS];
 
 
 /* Keyword lookup table */
-char* kw_table[] =
-{
-	"ELSE",
-	"FALSE",
-	"IF",
-	"PLATYPUS",
-	"READ",
-	"REPEAT",
-	"THEN",
-	"TRUE",
-	"WHILE",
-	"WRITE"
-};
+extern const char* const kw_table[KWT_SIZE];
+
+/* Keyword hash table - the kw_table index of the keyword that KW_HASH() maps to each slot, -1 for an empty slot */
+extern const signed char kw_hash[KWH_SIZE];
 
 #endif
 
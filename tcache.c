@@ -0,0 +1,301 @@
+/*
+ *	File name: tcache.c
+ *	Compiler: MS Visual Studio 2019, gcc / clang (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026, revised October 17th, 2026
+ *	Purpose: Implements the token cache. A cache file holds a whole token stream, its symbol table and the
+ *			 string literal table that goes with it, named after the FNV-1a hash of the source chars. Reading
+ *			 it back is a few sequential reads, so a run over unchanged sources is limited by the disk instead
+ *			 of the scanner. Everything read is checked before it is used, a damaged file is a cache miss.
+ *
+ *	Function list:  tc_hash()
+ *			tc_load()
+ *			tc_save()
+ *			tc_path()
+ *			tc_read()
+ *			tc_lexemes()
+ *			tc_check()
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>  /* fopen(), fread(), fwrite(), rename(), remove() */
+#include <string.h> /* strlen() */
+
+#ifdef _WIN32
+#include <direct.h>		/* _mkdir() */
+#define tc_mkdir(dir) _mkdir(dir)
+#else
+#include <sys/stat.h>	/* mkdir() */
+#define tc_mkdir(dir) mkdir((dir), 0777)
+#endif
+
+#include "tcache.h"
+#include "table.h"	/* KWT_SIZE */
+
+#define TC_FNV_BASIS 14695981039346656037ULL	/* FNV-1a 64 bit offset basis */
+#define TC_FNV_PRIME 1099511628211ULL			/* FNV-1a 64 bit prime */
+#define TC_CHUNK 4096	/* chars of the lexeme or string literal table read at a time */
+
+static int tc_path(char* path, const char* dir, unsigned long long hash, const char* ext);
+static int tc_read(FILE* fc, unsigned long long n, pBuffer dst);
+static int tc_lexemes(FILE* fc, unsigned long long n, pLexTable lt);
+static int tc_check(const TCacheHeader* hd, pTokenStream ts, pSymbolTable st, pBuffer str_LTBL);
+
+
+/*
+ *	Purpose: Hashes the chars of a source, the key of its cache file.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : None
+ *	Parameters : src: const char*, the source chars
+ *				 n: size_t, the number of chars
+ *	Return value : unsigned long long, the 64 bit FNV-1a hash of the n chars
+ *	Algorithm : N/A
+ */
+unsigned long long tc_hash(const char* src, size_t n)
+{
+	unsigned long long hash = TC_FNV_BASIS; /* hash so far */
+	size_t i; /* index of the char to hash */
+
+	for (i = 0; i < n; ++i) {
+		hash ^= (unsigned char)src[i];
+		hash *= TC_FNV_PRIME;
+	}
+	return hash;
+}
+
+
+/*
+ *	Purpose: Reads the tokens, the symbol table and the string literal table of a source back from its cache file.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.2 symbol table
+ *	Called functions : tc_path(), fopen(), fread(), fclose(), ts_reserve(), st_reserve(), lt_append(), b_clear(),
+ *					   b_view(), tc_read(), tc_lexemes(), tc_check()
+ *	Parameters : dir: const char*, the cache directory
+ *				 hash: unsigned long long, tc_hash() of the source
+ *				 src_size: size_t, the number of chars of the source
+ *				 ts: pTokenStream, an empty token stream that receives the tokens
+ *				 str_LTBL: pBuffer, the string literal table, cleared before the cached one is added to it
+ *				 st: pSymbolTable, an empty symbol table that receives the symbols, it becomes ts->symbols
+ *	Return value : 0 on success. 1 if there is no cache file for the source or it can't be used (another
+ *				   version, another build, a truncated or damaged file), ts, str_LTBL and st must then be
+ *				   emptied before they are used for anything else.
+ *	Algorithm : Check every field of the header against what this program expects, then read each array
+ *				in one call and the lexeme, name and string literal tables in chunks. The lexeme and name
+ *				tables must end with the null terminator of their last lexeme. Nothing read is trusted
+ *				before tc_check() has found every index and offset in it within what was read.
+ */
+int tc_load(const char* dir, unsigned long long hash, size_t src_size, pTokenStream ts, pBuffer str_LTBL, pSymbolTable st)
+{
+	char path[FILENAME_MAX]; /* cache file name */
+	TCacheHeader hd; /* header of the cache file */
+	FILE* fc; /* cache file */
+	size_t count; /* number of tokens */
+	size_t sym_count; /* number of symbols */
+	int ret = 1; /* return value */
+
+	if (tc_path(path, dir, hash, ".ptc") != 0 || (fc = fopen(path, "rb")) == NULL)
+		return 1;
+	if (fread(&hd, sizeof(hd), 1, fc) != 1 || hd.magic != TC_MAGIC || hd.version != TC_VERSION
+		|| hd.token_size != sizeof(PackedToken) || hd.line_size != sizeof(int) || hd.symbol_size != sizeof(SymbolRecord)
+		|| hd.hash != hash || hd.src_size != src_size || hd.count == 0 || hd.count > (size_t)-1
+		|| hd.sym_count > ST_MAX_SYMBOLS) {
+		fclose(fc);
+		return 1;
+	}
+	count = (size_t)hd.count;
+	sym_count = (size_t)hd.sym_count;
+	if (st_reserve(st, sym_count) == 0
+		&& fread(st->records, sizeof(SymbolRecord), sym_count, fc) == sym_count
+		&& ts_reserve(ts, count) == 0
+		&& fread(ts->token, sizeof(PackedToken), count, fc) == count
+		&& fread(ts->line, sizeof(int), count, fc) == count
+		&& ts->token[count - 1].code == SEOF_T
+		&& tc_lexemes(fc, hd.lex_size, &ts->lexemes) == 0
+		&& tc_lexemes(fc, hd.name_size, &st->names) == 0
+		&& b_clear(str_LTBL) == 0
+		&& tc_read(fc, hd.str_size, str_LTBL) == 0
+		&& tc_check(&hd, ts, st, str_LTBL) == 0) {
+		ts->count = count;
+		st->count = sym_count;
+		ts->symbols = st;
+		ret = 0;
+	}
+	fclose(fc);
+	return ret;
+}
+
+
+/*
+ *	Purpose: Saves the tokens, the symbol table and the string literal table of a source in its cache file.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.2 symbol table
+ *	Called functions : tc_path(), tc_mkdir(), fopen(), fwrite(), fclose(), remove(), rename(),
+ *					   b_limit(), b_view()
+ *	Parameters : dir: const char*, the cache directory, created if it doesn't exist
+ *				 hash: unsigned long long, tc_hash() of the source
+ *				 src_size: size_t, the number of chars of the source
+ *				 ts: pTokenStream, all the tokens of the source, the last one is SEOF_T. its symbol table
+ *					 (if any) is saved with it
+ *				 str_LTBL: pBuffer, the string literal table the tokens refer to
+ *	Return value : 0 on success, 1 if the file can't be written. Nothing is left behind on failure.
+ *	Algorithm : Write to a temporary file next to the cache file and rename it once it is complete, so
+ *				a run reading the cache never sees a partly written file.
+ */
+int tc_save(const char* dir, unsigned long long hash, size_t src_size, pTokenStream ts, pBuffer str_LTBL)
+{
+	char path[FILENAME_MAX]; /* cache file name */
+	char tmp[FILENAME_MAX]; /* temporary file name */
+	TCacheHeader hd = { 0 }; /* header of the cache file */
+	FILE* fc; /* temporary file */
+	size_t str_size = b_limit(str_LTBL); /* chars of the string literal table */
+	char* str = str_size ? b_view(str_LTBL, 0, str_size, NULL) : NULL; /* the string literal table */
+	size_t lex_size = ts->lexemes.chars ? b_limit(ts->lexemes.chars) : 0; /* chars of the lexeme table */
+	char* lex = lex_size ? b_view(ts->lexemes.chars, 0, lex_size, NULL) : NULL; /* the lexeme table */
+	size_t sym_count = ts->symbols ? ts->symbols->count : 0; /* number of symbols */
+	size_t name_size = sym_count ? b_limit(ts->symbols->names.chars) : 0; /* chars of the symbol names */
+	char* names = name_size ? b_view(ts->symbols->names.chars, 0, name_size, NULL) : NULL; /* the symbol names */
+	size_t count = ts->count; /* number of tokens */
+	int ok; /* all writes succeeded */
+
+	if (count == 0 || ts->token[count - 1].code != SEOF_T || (str_size && str == NULL) || (lex_size && lex == NULL)
+		|| (name_size && names == NULL))
+		return 1;
+	if (tc_path(path, dir, hash, ".ptc") != 0 || tc_path(tmp, dir, hash, ".tmp") != 0)
+		return 1;
+	tc_mkdir(dir); /* fails harmlessly if it exists */
+	if ((fc = fopen(tmp, "wb")) == NULL)
+		return 1;
+
+	hd.magic = TC_MAGIC;
+	hd.version = TC_VERSION;
+	hd.token_size = sizeof(PackedToken);
+	hd.line_size = sizeof(int);
+	hd.symbol_size = sizeof(SymbolRecord);
+	hd.hash = hash;
+	hd.src_size = src_size;
+	hd.count = count;
+	hd.lex_size = lex_size;
+	hd.sym_count = sym_count;
+	hd.name_size = name_size;
+	hd.str_size = str_size;
+	ok = fwrite(&hd, sizeof(hd), 1, fc) == 1
+		&& (sym_count == 0 || fwrite(ts->symbols->records, sizeof(SymbolRecord), sym_count, fc) == sym_count)
+		&& fwrite(ts->token, sizeof(PackedToken), count, fc) == count
+		&& fwrite(ts->line, sizeof(int), count, fc) == count
+		&& (lex_size == 0 || fwrite(lex, 1, lex_size, fc) == lex_size)
+		&& (name_size == 0 || fwrite(names, 1, name_size, fc) == name_size)
+		&& (str_size == 0 || fwrite(str, 1, str_size, fc) == str_size);
+	ok = (fclose(fc) == 0) && ok;
+
+#ifdef _WIN32
+	if (ok)
+		remove(path); /* rename() doesn't replace an existing file on Windows */
+#endif
+	if (!ok || rename(tmp, path) != 0) {
+		remove(tmp);
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ *	Purpose: Builds the name of the cache file of a source: dir/<16 hex digits of the hash><ext>.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : strlen(), sprintf()
+ *	Parameters : path: char*, receives the name, FILENAME_MAX chars
+ *				 dir: const char*, the cache directory
+ *				 hash: unsigned long long, tc_hash() of the source
+ *				 ext: const char*, the file name extension
+ *	Return value : 0 on success, 1 if the name doesn't fit in FILENAME_MAX chars
+ *	Algorithm : N/A
+ */
+static int tc_path(char* path, const char* dir, unsigned long long hash, const char* ext)
+{
+	if (strlen(dir) + 1 + 16 + strlen(ext) >= FILENAME_MAX)
+		return 1;
+	sprintf(path, "%s/%08lx%08lx%s", dir, (unsigned long)(hash >> 32), (unsigned long)(hash & 0xFFFFFFFFUL), ext);
+	return 0;
+}
+
+
+/* Reads n chars of a cache file into the end of dst, in chunks. Returns 0 on success, 1 if the file is too short or dst can't grow */
+static int tc_read(FILE* fc, unsigned long long n, pBuffer dst) {
+	char chunk[TC_CHUNK]; /* part of the chars */
+	size_t part; /* chars in chunk */
+
+	for (; n > 0; n -= part) {
+		part = n < TC_CHUNK ? (size_t)n : TC_CHUNK;
+		if (fread(chunk, 1, part, fc) != part || b_addn(dst, chunk, part) == NULL)
+			return 1;
+	}
+	return 0;
+}
+
+
+/* Reads the n chars of a lexeme table (an empty one) from a cache file. Returns 0 on success, 1 if they can't be read
+   or don't end with a null terminator */
+static int tc_lexemes(FILE* fc, unsigned long long n, pLexTable lt) {
+	return lt_append(lt, "", 0) == NULL || tc_read(fc, n, lt->chars) != 0
+		|| (n > 0 && *b_view(lt->chars, (size_t)n - 1, 1, NULL) != '\0');
+}
+
+
+/*
+ *	Purpose: Checks the tokens and symbols read from a cache file against the sizes of what was read.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_view()
+ *	Parameters : hd: const TCacheHeader*, the header of the file
+ *				 ts: pTokenStream, holds hd->count tokens and lines and the lexeme table
+ *				 st: pSymbolTable, holds hd->sym_count records and the name table
+ *				 str_LTBL: pBuffer, holds the hd->str_size chars of the string literal table
+ *	Return value : 0 if they can be used, 1 if the file is damaged
+ *	Algorithm : A symbol names a name at the start of a lexeme of the name table, after the name of the
+ *				symbol before it, with the flags of a type and no string. A token is within the source and
+ *				has a known code, its symbol index, lexeme, keyword or string literal is one of its table,
+ *				and its line is at least 1. The string literal table ends with a null terminator.
+ */
+static int tc_check(const TCacheHeader* hd, pTokenStream ts, pSymbolTable st, pBuffer str_LTBL)
+{
+	const char* names = hd->name_size ? b_view(st->names.chars, 0, (size_t)hd->name_size, NULL) : NULL; /* the symbol names */
+	const SymbolRecord* rec; /* a symbol */
+	const PackedToken* pt; /* a token */
+	size_t i; /* symbol or token index */
+
+	for (i = 0; i < hd->sym_count; ++i) {
+		rec = &st->records[i];
+		if (rec->name >= hd->name_size || (i > 0 && rec->name <= st->records[i - 1].name)
+			|| (rec->name > 0 && names[rec->name - 1] != '\0')
+			|| (rec->attr.flags & AV_TYPE) == 0 || (rec->attr.flags & ~(AV_TYPE | AV_VALUE)) != 0
+			|| ((rec->attr.flags & AV_TYPE) == AV_STRING && rec->attr.values.str_locator != NULL))
+			return 1;
+	}
+	for (i = 0; i < hd->count; ++i) {
+		pt = &ts->token[i];
+		if (pt->code > RTE_T || pt->offset > hd->src_size || pt->length > hd->src_size - pt->offset || ts->line[i] < 1)
+			return 1;
+		switch (pt->code) {
+		case AVID_T: case SVID_T:
+			if (pt->flags & PT_SYMBOL ? pt->value >= hd->sym_count : pt->value >= hd->lex_size)
+				return 1;
+			break;
+		case ERR_T: case RTE_T:
+			if (pt->value >= hd->lex_size)
+				return 1;
+			break;
+		case KW_T:
+			if (pt->value >= KWT_SIZE)
+				return 1;
+			break;
+		case STR_T:
+			if (pt->value >= hd->str_size)
+				return 1;
+			break;
+		}
+	}
+	return hd->str_size > 0 && *b_view(str_LTBL, (size_t)hd->str_size - 1, 1, NULL) != '\0';
+}
@@ -0,0 +1,52 @@
+#pragma once
+/*
+ *	File name: tcache.h
+ *	Compiler: MS Visual Studio 2019, gcc / clang (Makefile)
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026, revised October 17th, 2026
+ *	Purpose: Declares the token cache. The tokens of a source file, their lines, their lexeme table, the
+ *			 symbol table and the string literal table are saved in a cache directory under a hash of the
+ *			 source chars, so an unchanged source is read back instead of being scanned again. platy only
+ *			 uses the cache when the TC_ENV environment variable names its directory.
+ *
+ *	Function list: N/A (no function definitions, only declarations)
+ */
+
+#ifndef TCACHE_H_
+#define TCACHE_H_
+
+#include <stddef.h> /* size_t */
+
+#include "buffer.h"
+#include "scanner.h"
+
+#define TC_ENV "PLATY_CACHE"	/* environment variable naming the cache directory, nothing is cached unless it is set */
+#define TC_MAGIC 0x43544C50		/* "PLTC" in a little-endian file, a cache written on a machine of the other byte order doesn't match */
+#define TC_VERSION 5			/* changes whenever the file layout, the token codes or the attributes change */
+
+/* Header of a cache file. It is followed by the arrays of the token stream, each one read in with a single
+   call: sym_count symbol records, count packed tokens, count int lines, the lex_size chars of the lexeme
+   table, the name_size chars of the symbol names, then the str_size chars of the string literal table.
+   All of them in the native format */
+typedef struct TCacheHeader {
+	unsigned int magic;			/* TC_MAGIC */
+	unsigned int version;		/* TC_VERSION */
+	unsigned int token_size;	/* sizeof(PackedToken) of the program that wrote the file */
+	unsigned int line_size;		/* sizeof(int) of the program that wrote the file */
+	unsigned int symbol_size;	/* sizeof(SymbolRecord) of the program that wrote the file */
+	unsigned int reserved;		/* 0, keeps the 64 bit fields aligned */
+	unsigned long long hash;	/* tc_hash() of the source */
+	unsigned long long src_size;	/* number of chars of the source */
+	unsigned long long count;	/* number of tokens */
+	unsigned long long lex_size;	/* number of chars of the lexeme table */
+	unsigned long long sym_count;	/* number of symbols */
+	unsigned long long name_size;	/* number of chars of the symbol names */
+	unsigned long long str_size;	/* number of chars of the string literal table */
+} TCacheHeader;
+
+/* function declarations */
+unsigned long long tc_hash(const char* src, size_t n);
+int tc_load(const char* dir, unsigned long long hash, size_t src_size, pTokenStream ts, pBuffer str_LTBL, pSymbolTable st);
+int tc_save(const char* dir, unsigned long long hash, size_t src_size, pTokenStream ts, pBuffer str_LTBL);
+
+#endif
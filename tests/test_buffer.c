@@ -0,0 +1,364 @@
+/*
+ *	File name: test_buffer.c
+ *	Compiler: gcc / clang, built and run by "make test", also as test_buffer_stats with -DB_STATS
+ *	Author: Alex Carrozzi
+ *	Date: October 17th, 2026
+ *	Purpose: Tests of the buffer functions the scanner tests don't reach. A b_reserve() must leave room
+ *			 for the chars added after it, so the b_addn() calls that follow never grow the buffer. The
+ *			 random inserts and deletes of a GAP_MODE buffer must keep the chars and the get and mark
+ *			 offsets of a plain array edited the same way. b_addc_as() must grow a buffer of each growth
+ *			 policy as b_addc() grows one of the same mode. Built with B_STATS, the counters of a known
+ *			 sequence of appends and reads must be exact, and a b_reserve() followed by many b_addn() calls
+ *			 must grow the buffer once. Built without it, b_stats() must report the counters compiled out.
+ *			 Exits with EXIT_FAILURE and lists the checks that fail.
+ *
+ *	Function list:  main()
+ *			check_reserve()
+ *			check_gap()
+ *			check_addc_as()
+ *			check_stats()
+ *			same_chars()
+ *			rnd()
+ */
+
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* EXIT_SUCCESS, EXIT_FAILURE */
+#include <string.h> /* memcmp(), memmove(), memcpy(), memset() */
+
+#include "buffer.h"
+
+#define ADDS 1000		/* b_addn() calls after a b_reserve() */
+#define ADD_SIZE 7		/* chars added by each of them */
+#define EDITS 20000		/* random edits of the GAP_MODE buffer */
+#define EDIT_MAX 64		/* most chars of one edit */
+#define GAP_MAX 4096	/* most chars of the GAP_MODE buffer */
+
+static unsigned long rng = 1; /* state of rnd() */
+
+static int check_reserve(char mode, char inc_factor);
+static int check_gap(void);
+static int check_addc_as(void);
+static int check_stats(void);
+static int same_chars(pBuffer pBD, const char* chars, size_t n);
+static unsigned int rnd(void);
+
+
+/* Runs every check, returns EXIT_FAILURE if one of them fails */
+int main(void) {
+	int failed = 0; /* # of checks that failed */
+
+	failed += check_reserve('a', 15);
+	failed += check_reserve('m', 50);
+	failed += check_reserve('s', 0);
+	failed += check_reserve('f', 0);
+	failed += check_gap();
+	failed += check_addc_as();
+	failed += check_stats();
+	printf("test_buffer: %s\n", failed ? "FAILED" : "passed");
+	b_release();
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/*
+ *	Purpose: Checks that ADDS b_addn() calls after a b_reserve() of all their chars never grow the buffer.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_allocate(), b_addn(), b_reserve(), b_capacity(), b_location(), b_rflag(), same_chars(),
+ *					   memset(), printf(), b_free()
+ *	Parameters : mode: char, the o_mode of the buffer
+ *				 inc_factor: char, its increment factor
+ *	Return value : 0 on success, 1 on failure
+ *	Algorithm : The buffer starts with a few chars and too small a capacity. A FIXED_MODE buffer can't
+ *				grow, its b_reserve() must fail and leave it as it was.
+ */
+static int check_reserve(char mode, char inc_factor)
+{
+	static char chars[ADDS * ADD_SIZE + 3]; /* what the buffer should hold */
+	pBuffer pBD = b_allocate(16, inc_factor, mode); /* the buffer */
+	size_t capacity; /* capacity after the reserve */
+	char* head; /* address of the first char after the reserve */
+	size_t i; /* b_addn() call */
+
+	memset(chars, 'x', sizeof(chars));
+	if (pBD == NULL || b_addn(pBD, chars, 3) == NULL) {
+		printf("mode '%c': the buffer can't be made\n", mode);
+		b_free(pBD);
+		return 1;
+	}
+	if (mode == 'f') {
+		capacity = b_capacity(pBD);
+		i = b_reserve(pBD, ADDS * ADD_SIZE) != NULL || b_capacity(pBD) != capacity || !same_chars(pBD, chars, 3);
+		if (i)
+			printf("mode '%c': b_reserve() grew a buffer that can't grow\n", mode);
+		b_free(pBD);
+		return (int)i;
+	}
+	if (b_reserve(pBD, ADDS * ADD_SIZE) == NULL || b_capacity(pBD) < 3 + ADDS * ADD_SIZE) {
+		printf("mode '%c': b_reserve() didn't make room for %d chars\n", mode, ADDS * ADD_SIZE);
+		b_free(pBD);
+		return 1;
+	}
+	capacity = b_capacity(pBD);
+	head = b_location(pBD);
+	for (i = 0; i < ADDS; ++i) {
+		memset(chars + 3 + i * ADD_SIZE, 'a' + (int)(i % 26), ADD_SIZE);
+		if (b_addn(pBD, chars + 3 + i * ADD_SIZE, ADD_SIZE) == NULL || b_capacity(pBD) != capacity
+			|| b_location(pBD) != head || b_rflag(pBD)) {
+			printf("mode '%c': b_addn() %u after b_reserve() grew the buffer\n", mode, (unsigned)i);
+			b_free(pBD);
+			return 1;
+		}
+	}
+	i = !same_chars(pBD, chars, sizeof(chars));
+	if (i)
+		printf("mode '%c': the buffer doesn't hold the chars added\n", mode);
+	b_free(pBD);
+	return (int)i;
+}
+
+
+/*
+ *	Purpose: Checks a GAP_MODE buffer against a plain array through EDITS random inserts and deletes.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_allocate(), rnd(), b_insert(), b_delete(), b_mark(), b_reset(), b_getcoffset(), b_limit(),
+ *					   b_view(), memmove(), memcpy(), memcmp(), same_chars(), printf(), b_free()
+ *	Parameters : N/A
+ *	Return value : 0 on success, 1 on failure
+ *	Algorithm : Each edit is at a random offset, so the gap moves both ways. The get and mark offsets are
+ *				moved by the edit as b_insert() and b_delete() promise, then checked and set again at random.
+ *				A random span is viewed through a scratch buffer after each edit, it may straddle the gap.
+ *				The whole buffer is read back with b_getc() at the end.
+ */
+static int check_gap(void)
+{
+	static char model[GAP_MAX + EDIT_MAX]; /* the chars the buffer should hold */
+	char chars[EDIT_MAX]; /* chars of an insert */
+	pBuffer pBD = b_allocate(16, 0, 'g'); /* the buffer */
+	pBuffer scratch = b_allocate(16, 50, 'm'); /* copy of a span that straddles the gap */
+	size_t len = 0; /* chars of the model */
+	size_t getc = 0, mark = 0; /* where the get and mark offsets should be */
+	size_t off, n; /* offset and chars of an edit or a view */
+	size_t i; /* char of an insert */
+	char* view; /* a viewed span */
+	int edit; /* edit number */
+	int failed = 0; /* return value */
+
+	if (pBD == NULL || scratch == NULL) {
+		printf("GAP_MODE: the buffer can't be made\n");
+		failed = 1;
+	}
+	for (edit = 0; edit < EDITS && !failed; ++edit) {
+		off = rnd() % (len + 1);
+		n = rnd() % EDIT_MAX + 1;
+		if (len + n <= GAP_MAX && rnd() % 2) {
+			for (i = 0; i < n; ++i)
+				chars[i] = (char)rnd();
+			if (b_insert(pBD, off, chars, n) == NULL) {
+				printf("GAP_MODE: insert %d failed\n", edit);
+				failed = 1;
+				break;
+			}
+			memmove(model + off + n, model + off, len - off);
+			memcpy(model + off, chars, n);
+			len += n;
+			getc += getc > off ? n : 0;
+			mark += mark > off ? n : 0;
+		}
+		else {
+			if (b_delete(pBD, off, n) == NULL) {
+				printf("GAP_MODE: delete %d failed\n", edit);
+				failed = 1;
+				break;
+			}
+			n = n < len - off ? n : len - off;
+			memmove(model + off, model + off + n, len - off - n);
+			len -= n;
+			getc -= getc > off ? (getc - off < n ? getc - off : n) : 0;
+			mark -= mark > off ? (mark - off < n ? mark - off : n) : 0;
+		}
+		if (b_limit(pBD) != len || b_getcoffset(pBD) != getc) {
+			printf("GAP_MODE: after edit %d the buffer has %u chars and the get offset %u, not %u and %u\n", edit,
+				(unsigned)b_limit(pBD), (unsigned)b_getcoffset(pBD), (unsigned)len, (unsigned)getc);
+			failed = 1;
+			break;
+		}
+		b_reset(pBD);
+		if (b_getcoffset(pBD) != mark) {
+			printf("GAP_MODE: after edit %d the mark is %u, not %u\n", edit, (unsigned)b_getcoffset(pBD), (unsigned)mark);
+			failed = 1;
+			break;
+		}
+		getc = mark;
+		off = rnd() % (len + 1);
+		n = rnd() % (len - off + 1);
+		if (n > 0 && ((view = b_view(pBD, off, n, scratch)) == NULL || memcmp(view, model + off, n) != 0)) {
+			printf("GAP_MODE: after edit %d the %u chars at %u differ\n", edit, (unsigned)n, (unsigned)off);
+			failed = 1;
+			break;
+		}
+		mark = rnd() % (len + 1);
+		b_mark(pBD, mark);
+	}
+	if (!failed && !same_chars(pBD, model, len)) {
+		printf("GAP_MODE: the buffer doesn't hold the chars of the edits\n");
+		failed = 1;
+	}
+	b_free(pBD);
+	b_free(scratch);
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks that b_addc_as() fills and grows a buffer of each growth policy as b_addc() does.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_allocate_as(), b_allocate(), b_addc_as(), b_addc(), b_capacity(), b_limit(), b_location(),
+ *					   memcmp(), printf(), b_free()
+ *	Parameters : N/A
+ *	Return value : int, the number of policies that failed
+ *	Algorithm : The mode is a constant at every b_addc_as() call, as it is in the scanner. A FIXED_MODE
+ *				buffer must refuse the first char that doesn't fit.
+ */
+static int check_addc_as(void)
+{
+	static const char o_modes[] = "amf"; /* the o_mode of each policy */
+	pBuffer as[3], plain[3]; /* buffers filled by b_addc_as() and by b_addc() */
+	pBuffer r_as, r_plain; /* their returns */
+	int i; /* policy */
+	int k; /* char */
+	int failed = 0; /* # of policies that failed */
+
+	as[0] = b_allocate_as(10, 15, ADDITIVE_MODE);
+	as[1] = b_allocate_as(10, 50, MULTIPLICATIVE_MODE);
+	as[2] = b_allocate_as(10, 0, FIXED_MODE);
+	for (i = 0; i < 3; ++i)
+		plain[i] = b_allocate(10, i == 0 ? 15 : i == 1 ? 50 : 0, o_modes[i]);
+	for (i = 0; i < 3; ++i) {
+		for (k = 0; k < 2000 && as[i] != NULL && plain[i] != NULL; ++k) {
+			r_as = i == 0 ? b_addc_as(as[i], (char)k, ADDITIVE_MODE)
+				: i == 1 ? b_addc_as(as[i], (char)k, MULTIPLICATIVE_MODE) : b_addc_as(as[i], (char)k, FIXED_MODE);
+			r_plain = b_addc(plain[i], (char)k);
+			if ((r_as == NULL) != (r_plain == NULL) || b_capacity(as[i]) != b_capacity(plain[i]))
+				break;
+		}
+		if (k < 2000 || b_limit(as[i]) != b_limit(plain[i])
+			|| memcmp(b_location(as[i]), b_location(plain[i]), b_limit(as[i])) != 0) {
+			printf("b_addc_as() in mode '%c' differs from b_addc() at char %d\n", o_modes[i], k);
+			++failed;
+		}
+		b_free(as[i]);
+		b_free(plain[i]);
+	}
+	if (b_addc_as(NULL, 'x', MULTIPLICATIVE_MODE) != NULL) {
+		printf("b_addc_as() appended to no buffer\n");
+		++failed;
+	}
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks the counters of b_stats() for a known sequence of appends, reads and retracts.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : b_allocate(), b_capacity(), b_addc(), b_rflag(), b_rewind(), b_getc(), b_retract(), b_stats(),
+ *					   b_free(), b_reserve(), b_addn(), memset(), printf()
+ *	Parameters : N/A
+ *	Return value : 0 on success, 1 on failure
+ *	Algorithm : An ADDITIVE_MODE buffer of 10 bytes growing by 10 takes 35 chars in 3 grows. Whether a grow
+ *				moves the chars is up to realloc(), so the moves and the bytes copied expected are counted from
+ *				the r_flag after each b_addc(). The totals must take the counters of the buffer when it is freed.
+ */
+static int check_stats(void)
+{
+	static char chars[ADDS * ADD_SIZE]; /* chars of the b_addn() calls */
+	BufferStats stats, before, after; /* counters of the buffer, totals before and after it is freed */
+	pBuffer pBD = b_allocate(10, 10, 'a'); /* the buffer */
+	size_t grows = 0, moves = 0, copied = 0; /* what the counters should be */
+	size_t capacity; /* capacity before an append */
+	int k; /* char or call */
+	int failed = 0; /* return value */
+
+	if (pBD == NULL)
+		return 1;
+	for (k = 0; k < 35; ++k) {
+		capacity = b_capacity(pBD);
+		b_addc(pBD, 'x');
+		if (b_capacity(pBD) != capacity) {
+			++grows;
+			if (b_rflag(pBD)) {
+				++moves;
+				copied += capacity;
+			}
+		}
+	}
+	b_rewind(pBD);
+	for (k = 0; k < 35; ++k)
+		b_getc(pBD);
+	for (k = 0; k < 5; ++k)
+		b_retract(pBD);
+#ifdef B_STATS
+	if (b_stats(pBD, &stats) != 0 || grows != 3 || stats.grows != grows || stats.moves != moves || stats.copied != copied
+		|| stats.peak != 40 || stats.getcs != 35 || stats.retracts != 5) {
+		printf("b_stats(): grows %u moves %u copied %u peak %u getcs %u retracts %u, not %u %u %u 40 35 5\n",
+			(unsigned)stats.grows, (unsigned)stats.moves, (unsigned)stats.copied, (unsigned)stats.peak,
+			(unsigned)stats.getcs, (unsigned)stats.retracts, (unsigned)grows, (unsigned)moves, (unsigned)copied);
+		failed = 1;
+	}
+	b_stats(NULL, &before);
+	b_free(pBD);
+	b_stats(NULL, &after);
+	if (after.grows - before.grows != grows || after.moves - before.moves != moves || after.copied - before.copied != copied
+		|| after.getcs - before.getcs != 35 || after.retracts - before.retracts != 5 || after.peak < 40) {
+		printf("b_stats(): the totals didn't take the counters of the freed buffer\n");
+		failed = 1;
+	}
+
+	/* the point of b_reserve(): one reallocation for all the chars added after it */
+	pBD = b_allocate(16, 50, 'm');
+	memset(chars, 'x', sizeof(chars));
+	if (pBD == NULL || b_reserve(pBD, sizeof(chars)) == NULL)
+		failed = 1;
+	for (k = 0; k < ADDS && !failed; ++k)
+		b_addn(pBD, chars + k * ADD_SIZE, ADD_SIZE);
+	if (!failed && (b_stats(pBD, &stats) != 0 || stats.grows != 1)) {
+		printf("b_stats(): b_reserve() and %d b_addn() calls grew the buffer %u times, not once\n", ADDS, (unsigned)stats.grows);
+		failed = 1;
+	}
+#else
+	(void)chars;
+	memset(&stats, 0xFF, sizeof(stats));
+	if (b_stats(pBD, &stats) != RT_FAIL_1 || stats.grows != 0 || stats.moves != 0 || stats.copied != 0
+		|| stats.peak != 0 || stats.getcs != 0 || stats.retracts != 0) {
+		printf("b_stats(): counters compiled out but reported\n");
+		failed = 1;
+	}
+	(void)before, (void)after;
+#endif
+	b_free(pBD);
+	return failed;
+}
+
+
+/* Returns 1 if the buffer holds the n chars and nothing else, 0 if not */
+static int same_chars(pBuffer pBD, const char* chars, size_t n) {
+	size_t i; /* offset */
+
+	if (b_limit(pBD) != n)
+		return 0;
+	b_rewind(pBD);
+	for (i = 0; i < n; ++i)
+		if (b_getc(pBD) != chars[i])
+			return 0;
+	return 1;
+}
+
+
+/* The next number of a linear congruential generator, 15 bits */
+static unsigned int rnd(void) {
+	rng = rng * 1103515245UL + 12345UL;
+	return (unsigned int)(rng >> 16) & 0x7FFF;
+}
@@ -0,0 +1,1056 @@
+/*
+ *	File name: test_scan.c
+ *	Compiler: gcc / clang, built and run by "make test", also as test_scan_direct with -DDFA_DIRECT
+ *	Author: Alex Carrozzi
+ *	Date: October 17th, 2026
+ *	Purpose: Differential tests of the scanner. The serial scan of a compacted ADDITIVE_MODE buffer is the
+ *			 reference, the other buffer modes and a shared cursor of the reference buffer must give the same
+ *			 tokens, lines, offsets and string literals. Contexts scanning side by side, and the default
+ *			 context of scanner_init(), must not disturb each other. The token stream scanned in batches
+ *			 and its replay through malar_next_token() must give the tokens of the reference, and each token
+ *			 must unpack to the token it was packed from with its text interned once. With a symbol table,
+ *			 every VID must have the symbol of its name, in a source of a few names and in one of more
+ *			 names than a short can index. A stream saved in the token cache must be read back as it was.
+ *			 A few sources the reference itself could get wrong are checked against the tokens they must
+ *			 give. The parallel scan of a source of a few chunks must give the token stream, the lexemes,
+ *			 the symbols and the string literals of the serial scan. The sources are a few fixed ones and
+ *			 many generated from fragments of PLATYPUS with fixed seeds, so a failure can be reproduced.
+ *			 "test_scan dump" only prints the reference tokens of the sources: make test compares the dump
+ *			 of the table-driven scanner with the one of the DFA_DIRECT build.
+ *
+ *	Function list:  main()
+ *			gen_source()
+ *			load()
+ *			unload()
+ *			scan_ctx()
+ *			scan_batches()
+ *			scan_stream()
+ *			scan_replay()
+ *			check_same()
+ *			check_expected()
+ *			check_modes()
+ *			check_contexts()
+ *			check_stream()
+ *			check_pack()
+ *			check_cache()
+ *			check_symbols()
+ *			check_parallel()
+ *			same_streams()
+ *			dump()
+ *			sc_add()
+ *			sc_free()
+ *			tok_same()
+ *			rnd()
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>  /* printf(), sprintf(), tmpfile(), fopen(), fwrite(), rewind(), fclose(), remove() */
+#include <stdlib.h> /* malloc(), realloc(), free(), EXIT_SUCCESS, EXIT_FAILURE */
+#include <string.h> /* memcmp(), memcpy(), memset(), strcmp(), strlen() */
+
+#include "buffer.h"
+#include "scanner.h"
+#include "symtab.h"
+#include "loader.h"
+#include "tcache.h"
+#include "pscan.h"
+
+#define GEN_SOURCES 300		/* generated sources, seeds 1 to GEN_SOURCES */
+#define GEN_MAX 2000		/* most chars of a generated source */
+#define BIG_SIZE (3 * PS_MIN_CHUNK)	/* chars of the source of the parallel scan, room for three chunks */
+#define RING_SIZE 64		/* ring of the STREAM_MODE buffers, small so that it wraps many times */
+#define BATCH 7				/* most tokens scanned by one malar_next_tokens() call */
+#define CACHE_DIR "test_scan.cache"	/* token cache directory, removed at the end */
+#define MANY_NAMES 40000	/* names of the source of check_symbols(), more than SHRT_MAX */
+
+/* the globals the scanner expects its driver program to define (see platy.c) */
+pBuffer str_LTBL;
+int scerrnum;
+extern int line;	/* line of the last token of malar_next_token(), defined in scanner.c */
+
+/* a source loaded into a buffer, with what a STREAM_MODE buffer still reads from */
+typedef struct Loaded {
+	pBuffer buf;	/* the buffer */
+	FILE* fi;		/* the file a STREAM_MODE buffer reads from, NULL for the other modes */
+	pLoader ld;		/* the read-ahead loader feeding the buffer, NULL if it reads fi itself */
+} Loaded;
+
+/* the tokens of one scan, with the line and the offset of each one and the string literal table */
+typedef struct Scan {
+	Token* token;		/* the tokens, the last one SEOF_T or RTE_T */
+	int* line;			/* line of each token */
+	size_t* offset;		/* source offset of each token */
+	size_t count;		/* number of tokens */
+	size_t capacity;	/* tokens the arrays have room for */
+	pBuffer str;		/* the string literal table */
+} Scan;
+
+/* a buffer mode compared with the reference: the o_mode of load() and its name in the messages */
+typedef struct Mode {
+	char mode;			/* o_mode */
+	const char* name;	/* name */
+} Mode;
+
+/* the buffer modes compared with ADDITIVE_MODE */
+static const Mode modes[] = {
+	{ 'm', "MULTIPLICATIVE_MODE" },
+	{ 'f', "FIXED_MODE" },
+	{ 'r', "READONLY_MODE" },
+	{ 's', "SEGMENTED_MODE" },
+	{ 'i', "STREAM_MODE" },
+	{ 'l', "STREAM_MODE with the loader" },
+	{ 'g', "GAP_MODE" },
+};
+
+/* the fixed sources: a program, then the corners of the scanner */
+static const char* fixed[] = {
+	"",
+	"PLATYPUS {\n\tiCount = 0; a = 1.5; s$ = \"hello\";\n\tREPEAT WHILE (iCount < 10) .AND. (a <> 2.0) DO {\n"
+	"\t\tiCount = iCount + 1; a = a * 2.0;\n\t\ts$ = s$ << \" world\";\n\t};\n"
+	"\tIF TRUE (a == 4.0) THEN { WRITE(s$); } ELSE { READ(a, iCount); };\n\tWRITE(\"done\");\n}\n",
+	"!! a comment\r\n!< another\r!x\n! \"not a string\n\"a string\r\nover two lines\"",
+	"verylongidentifier vlongstr$ 0 007 32767 32768 99999999 1.0 0.0 340282347000000000000000000000000000000.0 .5 5. 1..2 a@ @",
+	"\"unterminated string literal that goes on and on to the end of the source",
+	"x = 1;!",
+	"= == <> < > << + - * / ( ) { } , ; .AND. .OR. .NOT. .AND .ANDX. # $ %",
+	"\r\n\r\n   \t\v\f\n\r  a\r\rb\n\nc",
+	"a\xff b c",
+	"a=1;!\xff\nb=2;\n",
+};
+
+/* a source and the codes and lines of its tokens, the line being where the scanner is after the token */
+typedef struct Expected {
+	const char* src;	/* the source */
+	int count;			/* number of tokens */
+	int code[12];		/* their codes */
+	int line[12];		/* their lines */
+} Expected;
+
+/* the sources of check_expected(): a char 0xFF after a '!' ends the source only if it is the sentinel */
+static const Expected expected[] = {
+	{ "a=1;!\xff\nb=2;\n", 10, { AVID_T, ASS_OP_T, INL_T, EOS_T, ERR_T, AVID_T, ASS_OP_T, INL_T, EOS_T, SEOF_T },
+		{ 1, 1, 1, 1, 2, 2, 2, 2, 2, 3 } },
+	{ "x = 1;!", 6, { AVID_T, ASS_OP_T, INL_T, EOS_T, ERR_T, SEOF_T }, { 1, 1, 1, 1, 1, 1 } },
+	{ "!\xff", 2, { ERR_T, SEOF_T }, { 1, 1 } },
+};
+
+/* fragments the generated sources are made of */
+static const char* frag[] = {
+	"\"", "!", "!!", "\n", "\r", "\r\n", " ", "\t", "\v", "  \t\n", "abc", "x$", "AB", "AB0", "a@", "9a",
+	"iabcdefghijklm", "wlongname$", "IF", "THEN", "ELSE", "WRITE", "PLATYPUS", "TRUE", "REPEAT",
+	"0", "0.", "12", "12.5", "007", "0.5", ".5", "0x", "x1.2", "99999999", "32767", "@", "#", "<<", "=",
+	"==", "<>", "<", ">", "+", "-", "*", "/", ";", ",", "(", ")", "{", "}", ".AND.", ".OR.", ".NOT", ".",
+	"\"str\nx\"", "\"ab\r\ncd\"", "\"\"", "!<c\n", "!! x\r\n", "\x01", "\x80"
+};
+
+static unsigned long rng; /* state of rnd() */
+
+static size_t gen_source(char* dst, size_t max, unsigned long seed);
+static int load(Loaded* l, const char* src, size_t n, char mode);
+static void unload(Loaded* l);
+static int scan_ctx(pBuffer sc_buf, size_t n, pSymbolTable st, Scan* s);
+static int scan_batches(pBuffer sc_buf, pSymbolTable st, pBuffer str, pTokenStream ts);
+static int scan_stream(pTokenStream ts, Scan* s);
+static int scan_replay(pBuffer sc_buf, pTokenStream ts, Scan* s);
+static int check_same(const char* name, const char* what, Scan* ref, Scan* s);
+static int check_expected(void);
+static int check_modes(const char* name, const char* src, size_t n);
+static int check_contexts(const char* name, const char* src, size_t n);
+static int check_stream(const char* name, const char* src, size_t n);
+static int check_pack(const char* name, Scan* ref);
+static int check_cache(const char* name, const char* src, size_t n, pTokenStream ts, pBuffer str);
+static int check_symbols(void);
+static int check_parallel(void);
+static int same_streams(pTokenStream a, pBuffer a_str, pTokenStream b, pBuffer b_str);
+static void dump(const char* name, const char* src, size_t n);
+static int sc_add(Scan* s, const Token* t, int line, size_t offset);
+static void sc_free(Scan* s);
+static int tok_same(const Token* a, const Token* b);
+static unsigned int rnd(void);
+
+
+/*
+ *	Purpose: Runs every check on every source, or dumps the reference tokens of the sources.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : strcmp(), malloc(), b_allocate(), strlen(), memcpy(), sprintf(), gen_source(), dump(),
+ *					   check_modes(), check_contexts(), check_stream(), check_expected(), check_symbols(),
+ *					   check_parallel(), remove(), printf(), free(), b_free(), b_release()
+ *	Parameters : argc: int, argument count
+ *				 argv: char**, "dump" as argv[1] prints the tokens instead of checking them
+ *	Return value : EXIT_SUCCESS, or EXIT_FAILURE if a check fails
+ *	Algorithm : N/A
+ */
+int main(int argc, char** argv)
+{
+	int dumping = argc > 1 && strcmp(argv[1], "dump") == 0; /* print the tokens only */
+	size_t fixed_count = sizeof(fixed) / sizeof(fixed[0]); /* number of fixed sources */
+	char* src = (char*)malloc(GEN_MAX); /* the source */
+	char name[32]; /* name of the source in the messages */
+	size_t n; /* chars of the source */
+	size_t i; /* source index */
+	int failed = 0; /* # of checks that failed */
+
+	str_LTBL = b_allocate(100, 100, 'm');	/* only scanner_init() uses it, in check_contexts() and scan_replay() */
+	if (src == NULL || str_LTBL == NULL) {
+		printf("test_scan: out of memory\n");
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < fixed_count + GEN_SOURCES; ++i) {
+		if (i < fixed_count) {
+			sprintf(name, "fixed source %u", (unsigned)i);
+			n = strlen(fixed[i]);
+			memcpy(src, fixed[i], n);
+		}
+		else {
+			sprintf(name, "seed %u", (unsigned)(i - fixed_count + 1));
+			n = gen_source(src, GEN_MAX, (unsigned long)(i - fixed_count + 1));
+		}
+		if (dumping)
+			dump(name, src, n);
+		else
+			failed += check_modes(name, src, n) + check_contexts(name, src, n) + check_stream(name, src, n);
+	}
+	if (!dumping) {
+		failed += check_expected();
+		failed += check_symbols();
+		failed += check_parallel();
+		remove(CACHE_DIR);
+		printf("test_scan: %s\n", failed ? "FAILED" : "passed");
+	}
+	free(src);
+	b_free(str_LTBL);
+	b_release();
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/* Fills dst with fragments picked with the seed, fewer than max chars. Returns the number of chars */
+static size_t gen_source(char* dst, size_t max, unsigned long seed) {
+	size_t n = 0; /* chars so far */
+	size_t want; /* chars wanted */
+	size_t len; /* chars of the fragment */
+	const char* f; /* the fragment */
+
+	rng = seed;
+	want = rnd() % max;
+	while (1) {
+		f = frag[rnd() % (sizeof(frag) / sizeof(frag[0]))];
+		len = strlen(f);
+		if (n + len > want)
+			return n;
+		memcpy(dst + n, f, len);
+		n += len;
+	}
+}
+
+
+/*
+ *	Purpose: Loads a source into a new buffer through a temporary file, the way platy does, and compacts
+ *			 it with the SEOF sentinel.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : tmpfile(), fwrite(), rewind(), b_allocate(), b_load(), l_open(), b_source(), b_compact(),
+ *					   b_mode(), fclose(), unload()
+ *	Parameters : l: Loaded*, receives the buffer and what it reads from
+ *				 src: const char*, the source
+ *				 n: size_t, chars of the source
+ *				 mode: char, the o_mode of b_allocate(), or 'l' for a STREAM_MODE buffer fed by the read-ahead loader
+ *	Return value : 0 on success, 1 if the source can't be loaded
+ *	Algorithm : N/A
+ */
+static int load(Loaded* l, const char* src, size_t n, char mode)
+{
+	size_t loaded; /* return of b_load() */
+
+	l->ld = NULL;
+	l->buf = NULL;
+	if ((l->fi = tmpfile()) == NULL || (n > 0 && fwrite(src, 1, n, l->fi) != n)) {
+		unload(l);
+		return 1;
+	}
+	rewind(l->fi);
+	switch (mode) {
+	case 'f': l->buf = b_allocate(n + 1, 0, 'f'); break;	/* room for the sentinel, it can't grow */
+	case 'r': case 's': l->buf = b_allocate(0, 0, mode); break;
+	case 'i': case 'l': l->buf = b_allocate(RING_SIZE, 0, 'i'); break;
+	case 'g': l->buf = b_allocate(16, 0, 'g'); break;
+	default: l->buf = b_allocate(16, 15, mode);
+	}
+	if (l->buf != NULL && mode == 'l')
+		loaded = (l->ld = l_open(l->fi, RING_SIZE / 2)) != NULL && b_source(l->buf, l_refill, l->ld) != NULL ? 0 : RT_FAIL_1;
+	else
+		loaded = l->buf != NULL ? b_load(l->fi, l->buf) : RT_FAIL_1;
+	if (loaded == RT_FAIL_1 || loaded == LOAD_FAIL || b_compact(l->buf, EOF) == NULL) {
+		unload(l);
+		return 1;
+	}
+	if (b_mode(l->buf) != STREAM_MODE) {
+		fclose(l->fi);
+		l->fi = NULL;
+	}
+	return 0;
+}
+
+
+/* Frees the buffer of a loaded source and closes what it reads from */
+static void unload(Loaded* l) {
+	if (l->ld != NULL)
+		l_close(l->ld);
+	if (l->fi != NULL)
+		fclose(l->fi);
+	b_free(l->buf);
+	l->ld = NULL;
+	l->fi = NULL;
+	l->buf = NULL;
+}
+
+
+/*
+ *	Purpose: Scans a buffer one token at a time with a context of its own.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : memset(), b_allocate(), scanner_init_ctx(), malar_next_token_ctx(), sc_add(), scanner_free_ctx()
+ *	Parameters : sc_buf: pBuffer, the compacted source
+ *				 n: size_t, chars of the source, a STREAM_MODE buffer holds only some of them
+ *				 st: pSymbolTable, the symbol table of the context, NULL for none
+ *				 s: Scan*, an empty scan, receives the tokens and a new string literal table
+ *	Return value : 0 on success, 1 if the scan couldn't be made or doesn't end
+ *	Algorithm : A scan that doesn't end within one token per char of the source plus one is stuck.
+ */
+static int scan_ctx(pBuffer sc_buf, size_t n, pSymbolTable st, Scan* s)
+{
+	ScannerContext ctx; /* context of the scan */
+	size_t most = n + 1; /* most tokens the source can have */
+	Token t; /* a token */
+	int ret = 1; /* return value */
+
+	memset(&ctx, 0, sizeof(ctx));
+	if ((s->str = b_allocate(100, 100, 'm')) == NULL || scanner_init_ctx(&ctx, sc_buf, s->str) != 0)
+		return 1;
+	ctx.symbols = st;
+	while (s->count < most) {
+		t = malar_next_token_ctx(&ctx);
+		if (sc_add(s, &t, ctx.line, ctx.tok_offset) != 0)
+			break;
+		if (t.code == SEOF_T || t.code == RTE_T) {
+			ret = 0;
+			break;
+		}
+	}
+	scanner_free_ctx(&ctx);
+	return ret;
+}
+
+
+/* Scans a buffer into a token stream BATCH tokens at a time, with the symbol table st (NULL for none) and the
+   string literal table str. Returns 0 on success, 1 if the stream couldn't be made */
+static int scan_batches(pBuffer sc_buf, pSymbolTable st, pBuffer str, pTokenStream ts) {
+	ScannerContext ctx; /* context of the scan */
+	int ret = 1; /* return value */
+
+	memset(&ctx, 0, sizeof(ctx));
+	if (scanner_init_ctx(&ctx, sc_buf, str) != 0)
+		return 1;
+	ctx.symbols = st;
+	while (malar_next_tokens(&ctx, ts, BATCH) > 0)
+		if (ts->token[ts->count - 1].code == SEOF_T || ts->token[ts->count - 1].code == RTE_T) {
+			ret = 0;
+			break;
+		}
+	scanner_free_ctx(&ctx);
+	return ret;
+}
+
+
+/* Unpacks the tokens of a stream into an empty scan, with their names and flags from its symbol table.
+   Returns 0 on success, 1 if the scan can't grow */
+static int scan_stream(pTokenStream ts, Scan* s) {
+	Token t; /* a token */
+	size_t i; /* token index */
+
+	for (i = 0; i < ts->count; ++i) {
+		t = pt_unpack(&ts->token[i], &ts->lexemes);
+		if (ts->symbols != NULL && (t.avid_attribute.flags & AV_SYMBOL))
+			st_token(ts->symbols, &t);
+		if (sc_add(s, &t, ts->line[i], ts->token[i].offset) != 0)
+			return 1;
+	}
+	return 0;
+}
+
+
+/* Replays a stream through scanner_init() and malar_next_token() into an empty scan. The offsets are the
+   stream's, the replay doesn't give them. Returns 0 on success, 1 if the replay doesn't end with the stream */
+static int scan_replay(pBuffer sc_buf, pTokenStream ts, Scan* s) {
+	Token t; /* a token */
+
+	if (scanner_init(sc_buf) != 0)
+		return 1;
+	scanner_replay(ts);
+	while (s->count < ts->count) {
+		t = malar_next_token();
+		if (sc_add(s, &t, line, ts->token[s->count].offset) != 0)
+			return 1;
+		if (t.code == SEOF_T || t.code == RTE_T)
+			break;
+	}
+	return s->count != ts->count;
+}
+
+
+/*
+ *	Purpose: Compares a scan with the reference scan of the same source.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : tok_same(), b_limit(), b_view(), memcmp(), printf()
+ *	Parameters : name: const char*, the source
+ *				 what: const char*, the mode or path of the scan
+ *				 ref: Scan*, the reference scan
+ *				 s: Scan*, the scan
+ *	Return value : 0 if they are the same, 1 (after printing the first difference) if not
+ *	Algorithm : The string literal tables are compared in full if the scan has one.
+ */
+static int check_same(const char* name, const char* what, Scan* ref, Scan* s)
+{
+	size_t i; /* token index */
+	size_t n; /* chars of the string literal table */
+
+	for (i = 0; i < ref->count && i < s->count; ++i)
+		if (!tok_same(&ref->token[i], &s->token[i]) || ref->line[i] != s->line[i] || ref->offset[i] != s->offset[i]) {
+			printf("%s, %s: token %u is code %d line %d offset %u, the reference has code %d line %d offset %u\n",
+				name, what, (unsigned)i, s->token[i].code, s->line[i], (unsigned)s->offset[i],
+				ref->token[i].code, ref->line[i], (unsigned)ref->offset[i]);
+			return 1;
+		}
+	if (ref->count != s->count) {
+		printf("%s, %s: %u tokens, the reference has %u\n", name, what, (unsigned)s->count, (unsigned)ref->count);
+		return 1;
+	}
+	n = b_limit(ref->str);
+	if (s->str != NULL && (b_limit(s->str) != n
+		|| (n > 0 && memcmp(b_view(ref->str, 0, n, NULL), b_view(s->str, 0, n, NULL), n) != 0))) {
+		printf("%s, %s: the string literal table differs from the reference\n", name, what);
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ *	Purpose: Checks that scans of a source side by side don't disturb each other.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : load(), scan_ctx(), b_allocate(), scanner_init_ctx(), scanner_init(),
+ *					   malar_next_token_ctx(), malar_next_token(), sc_add(), check_same(), scanner_free_ctx(),
+ *					   sc_free(), unload(), memset(), printf()
+ *	Parameters : name: const char*, name of the source
+ *				 src: const char*, the source
+ *				 n: size_t, chars of the source
+ *	Return value : int, the number of scans that differ from the reference
+ *	Algorithm : Two contexts and the default one of scanner_init() and malar_next_token() take one token
+ *				each in turn, each from a buffer of its own. The default context doesn't give the offsets
+ *				of its tokens, they are taken from the reference. Its string literals go to str_LTBL.
+ */
+static int check_contexts(const char* name, const char* src, size_t n)
+{
+	static const char* what[] = { "first context", "second context", "scanner_init()" }; /* the scans */
+	Loaded ref_buf, l[3]; /* the reference buffer and the one of each scan */
+	Scan ref = { 0 }, s[3]; /* the reference scan and the others */
+	ScannerContext ctx[2]; /* the contexts of the first two scans */
+	int done[3] = { 0, 0, 0 }; /* the scan has ended */
+	Token t; /* a token */
+	size_t offset; /* offset of the token */
+	int failed = 0; /* # of scans that failed */
+	int k; /* scan index */
+
+	memset(l, 0, sizeof(l));
+	memset(s, 0, sizeof(s));
+	memset(ctx, 0, sizeof(ctx));
+	if (load(&ref_buf, src, n, 'a') != 0 || scan_ctx(ref_buf.buf, n, NULL, &ref) != 0) {
+		printf("%s: the reference scan failed\n", name);
+		sc_free(&ref);
+		unload(&ref_buf);
+		return 1;
+	}
+	for (k = 0; k < 3; ++k)
+		if (load(&l[k], src, n, 'a') != 0 || (k < 2 && ((s[k].str = b_allocate(100, 100, 'm')) == NULL
+			|| scanner_init_ctx(&ctx[k], l[k].buf, s[k].str) != 0))
+			|| (k == 2 && scanner_init(l[k].buf) != 0)) {
+			printf("%s, %s: the scan failed\n", name, what[k]);
+			failed = 1;
+			break;
+		}
+	while (!failed && !(done[0] && done[1] && done[2]))
+		for (k = 0; k < 3; ++k) {
+			if (done[k])
+				continue;
+			if (k < 2) {
+				t = malar_next_token_ctx(&ctx[k]);
+				offset = ctx[k].tok_offset;
+			}
+			else {
+				t = malar_next_token();
+				offset = s[k].count < ref.count ? ref.offset[s[k].count] : 0;
+			}
+			/* a scan with more tokens than the reference can stop, it differs already */
+			if (sc_add(&s[k], &t, k < 2 ? ctx[k].line : line, offset) != 0 || t.code == SEOF_T || t.code == RTE_T
+				|| s[k].count > ref.count)
+				done[k] = 1;
+		}
+	for (k = 0; k < 3 && !failed; ++k)
+		failed += check_same(name, what[k], &ref, &s[k]);
+	s[2].str = NULL;	/* str_LTBL, borrowed */
+	for (k = 0; k < 3; ++k) {
+		if (k < 2)
+			scanner_free_ctx(&ctx[k]);
+		sc_free(&s[k]);
+		unload(&l[k]);
+	}
+	sc_free(&ref);
+	unload(&ref_buf);
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks the token stream scanned in batches, and its replay, against the scan of a source one
+ *			 token at a time, the symbol table, and the token cache with a stream that has a symbol table.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : load(), scan_ctx(), st_init(), ts_init(), b_allocate(), scan_batches(), scan_stream(),
+ *					   scan_replay(), check_same(), check_pack(), st_name(), strcmp(), memset(), tok_same(),
+ *					   check_cache(), printf(), sc_free(), ts_free(), st_free(), b_free(), unload()
+ *	Parameters : name: const char*, name of the source
+ *				 src: const char*, the source
+ *				 n: size_t, chars of the source
+ *	Return value : int, the number of checks that failed
+ *	Algorithm : The batches are smaller than most sources, so a token stream takes a few calls of
+ *				malar_next_tokens(). The string literal table of the stream is the one it was scanned with.
+ *				With a symbol table, the scan one token at a time with one is the reference: the stream
+ *				must unpack to it and its replay must return it, and without their avid_attribute its
+ *				tokens must be the tokens of the first reference. The symbol of each VID must have its name.
+ */
+static int check_stream(const char* name, const char* src, size_t n)
+{
+	Loaded l; /* the source */
+	Scan ref = { 0 }, ref_st = { 0 }, s = { 0 }; /* the reference scans, without and with symbols, and another scan */
+	SymbolTable st_ref, st; /* symbol tables of ref_st and of the stream with symbols */
+	TokenStream ts, ts_st; /* the streams without and with symbols */
+	pBuffer str = NULL, str_st = NULL; /* their string literal tables */
+	Token t; /* a token of ref_st without its avid_attribute */
+	size_t i; /* token index */
+	int failed = 0; /* # of checks that failed */
+
+	st_init(&st_ref);
+	st_init(&st);
+	ts_init(&ts);
+	ts_init(&ts_st);
+	if (load(&l, src, n, 'a') != 0 || scan_ctx(l.buf, n, NULL, &ref) != 0 || scan_ctx(l.buf, n, &st_ref, &ref_st) != 0
+		|| (str = b_allocate(100, 100, 'm')) == NULL || (str_st = b_allocate(100, 100, 'm')) == NULL
+		|| scan_batches(l.buf, NULL, str, &ts) != 0 || scan_batches(l.buf, &st, str_st, &ts_st) != 0) {
+		printf("%s: the scans of the stream checks failed\n", name);
+		++failed;
+	}
+	else {
+		s.str = str;
+		failed += scan_stream(&ts, &s) != 0 || check_same(name, "token stream", &ref, &s);
+		s.str = NULL;	/* borrowed */
+		sc_free(&s);
+		failed += scan_replay(l.buf, &ts, &s) != 0 || check_same(name, "replay", &ref, &s);
+		sc_free(&s);
+		failed += check_pack(name, &ref);
+		s.str = str_st;
+		failed += scan_stream(&ts_st, &s) != 0 || check_same(name, "token stream with symbols", &ref_st, &s);
+		s.str = NULL;
+		sc_free(&s);
+		failed += scan_replay(l.buf, &ts_st, &s) != 0 || check_same(name, "replay with symbols", &ref_st, &s);
+		sc_free(&s);
+
+		for (i = 0; i < ref_st.count; ++i) {
+			t = ref_st.token[i];
+			if ((t.code == AVID_T || t.code == SVID_T) && (!(t.avid_attribute.flags & AV_SYMBOL)
+				|| strcmp(st_name(&st_ref, t.avid_attribute.values.int_value), t.attribute.vid_lex) != 0)) {
+				printf("%s, symbol table: token %u (%s) doesn't have the symbol of its name\n", name, (unsigned)i, t.attribute.vid_lex);
+				++failed;
+				break;
+			}
+			memset(&t.avid_attribute, 0, sizeof(t.avid_attribute));
+			if (!tok_same(&t, &ref.token[i])) {
+				printf("%s, symbol table: token %u differs from the scan without symbols\n", name, (unsigned)i);
+				++failed;
+				break;
+			}
+		}
+		if (st.count != st_ref.count) {
+			printf("%s, symbol table: the stream has %u symbols, the reference %u\n", name, (unsigned)st.count, (unsigned)st_ref.count);
+			++failed;
+		}
+		if (ts_st.token[ts_st.count - 1].code == SEOF_T)
+			failed += check_cache(name, src, n, &ts_st, str_st);
+	}
+	sc_free(&ref);
+	sc_free(&ref_st);
+	ts_free(&ts);
+	ts_free(&ts_st);
+	st_free(&st_ref);
+	st_free(&st);
+	b_free(str);
+	b_free(str_st);
+	unload(&l);
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks that the tokens of a scan unpack to themselves and that each text is interned once.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : lt_init(), pt_pack(), pt_unpack(), tok_same(), lt_lexeme(), lt_intern(), strcmp(),
+ *					   lt_free(), printf()
+ *	Parameters : name: const char*, name of the source
+ *				 ref: Scan*, the reference scan
+ *	Return value : 0 on success, 1 on failure
+ *	Algorithm : Each token is packed with its offset and the chars up to the next token as its length.
+ *				The text of a VID or an error token must be the lexeme of its index, and interning the
+ *				text again must give the same index without adding a lexeme.
+ */
+static int check_pack(const char* name, Scan* ref)
+{
+	LexTable lt; /* lexemes of the packed tokens */
+	PackedToken pt; /* a packed token */
+	Token t; /* the token unpacked */
+	const char* text; /* the text of a VID or an error token */
+	size_t length; /* the length packed */
+	size_t count; /* lexemes before interning a text again */
+	size_t i; /* token index */
+	int failed = 0; /* return value */
+
+	lt_init(&lt);
+	for (i = 0; i < ref->count && !failed; ++i) {
+		length = i + 1 < ref->count ? ref->offset[i + 1] - ref->offset[i] : 0;
+		if (pt_pack(&ref->token[i], ref->offset[i], length, &lt, &pt) != 0) {
+			printf("%s, packed token %u: it can't be packed\n", name, (unsigned)i);
+			failed = 1;
+			break;
+		}
+		t = pt_unpack(&pt, &lt);
+		if (!tok_same(&t, &ref->token[i]) || pt.offset != ref->offset[i] || pt.length != length) {
+			printf("%s, packed token %u: code %d offset %u length %u unpacks to code %d offset %u length %u\n", name,
+				(unsigned)i, ref->token[i].code, (unsigned)ref->offset[i], (unsigned)length, t.code, (unsigned)pt.offset, (unsigned)pt.length);
+			failed = 1;
+		}
+		if (!(pt.flags & PT_INTERNED))
+			continue;
+		text = pt.code == AVID_T || pt.code == SVID_T ? ref->token[i].attribute.vid_lex : ref->token[i].attribute.err_lex;
+		count = lt.count;
+		if (strcmp(lt_lexeme(&lt, pt.value), text) != 0 || lt_intern(&lt, text) != pt.value || lt.count != count) {
+			printf("%s, packed token %u: the text \"%s\" isn't interned once\n", name, (unsigned)i, text);
+			failed = 1;
+		}
+	}
+	lt_free(&lt);
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks that a token stream saved in the token cache is read back as it was, and that a damaged
+ *			 cache file is rejected.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : tc_hash(), tc_save(), tc_load(), same_streams(), sprintf(), fopen(), fseek(), fputc(),
+ *					   fclose(), remove(), ts_init(), st_init(), b_allocate(), ts_free(), st_free(), b_free(), printf()
+ *	Parameters : name: const char*, name of the source
+ *				 src: const char*, the source
+ *				 n: size_t, chars of the source
+ *				 ts: pTokenStream, the stream of the source, with its symbol table, ending with SEOF_T
+ *				 str: pBuffer, its string literal table
+ *	Return value : 0 on success, 1 on failure
+ *	Algorithm : The code of the first token is damaged by writing a code no token has over it.
+ */
+static int check_cache(const char* name, const char* src, size_t n, pTokenStream ts, pBuffer str)
+{
+	unsigned long long hash = tc_hash(src, n); /* the key of the file */
+	char path[FILENAME_MAX]; /* the cache file */
+	TokenStream ts2; /* the stream read back */
+	SymbolTable st2; /* its symbol table */
+	pBuffer str2 = b_allocate(100, 100, 'm'); /* its string literal table */
+	FILE* fc; /* the cache file, to damage it */
+	int failed = 1; /* return value */
+
+	ts_init(&ts2);
+	st_init(&st2);
+	sprintf(path, "%s/%08lx%08lx.ptc", CACHE_DIR, (unsigned long)(hash >> 32), (unsigned long)(hash & 0xFFFFFFFFUL));
+	if (str2 == NULL || tc_save(CACHE_DIR, hash, n + 1, ts, str) != 0)
+		printf("%s, token cache: the stream can't be saved\n", name);
+	else if (tc_load(CACHE_DIR, hash, n + 1, &ts2, str2, &st2) != 0)
+		printf("%s, token cache: the stream can't be read back\n", name);
+	else if (same_streams(ts, str, &ts2, str2) != 0)
+		printf("%s, token cache: the stream read back differs\n", name);
+	else if ((fc = fopen(path, "r+b")) == NULL || fseek(fc, (long)(sizeof(TCacheHeader) + ts->symbols->count * sizeof(SymbolRecord)), SEEK_SET) != 0
+		|| fputc(0xEE, fc) == EOF || fclose(fc) != 0)
+		printf("%s, token cache: the file can't be damaged\n", name);
+	else {
+		ts_free(&ts2);
+		st_free(&st2);
+		if (tc_load(CACHE_DIR, hash, n + 1, &ts2, str2, &st2) == 0)
+			printf("%s, token cache: a damaged file is read back\n", name);
+		else
+			failed = 0;
+	}
+	remove(path);
+	ts_free(&ts2);
+	st_free(&st2);
+	b_free(str2);
+	return failed;
+}
+
+
+/* Checks the codes and lines of the tokens of the expected sources, returns the # of sources that fail */
+static int check_expected(void) {
+	Loaded l; /* a source */
+	Scan s; /* its scan */
+	size_t i; /* source index */
+	int k; /* token index */
+	int failed = 0; /* # of sources that failed */
+
+	for (i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+		memset(&s, 0, sizeof(s));
+		if (load(&l, expected[i].src, strlen(expected[i].src), 'a') != 0
+			|| scan_ctx(l.buf, strlen(expected[i].src), NULL, &s) != 0)
+			k = -1;
+		else
+			for (k = 0; k < expected[i].count && (size_t)k < s.count; ++k)
+				if (s.token[k].code != expected[i].code[k] || s.line[k] != expected[i].line[k])
+					break;
+		if (k != expected[i].count || s.count != (size_t)k) {
+			printf("expected source %u: token %d is code %d line %d, not code %d line %d\n", (unsigned)i, k,
+				k >= 0 && (size_t)k < s.count ? s.token[k].code : -1, k >= 0 && (size_t)k < s.count ? s.line[k] : -1,
+				k >= 0 && k < expected[i].count ? expected[i].code[k] : -1, k >= 0 && k < expected[i].count ? expected[i].line[k] : -1);
+			++failed;
+		}
+		sc_free(&s);
+		unload(&l);
+	}
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks that every buffer mode and a shared cursor scan a source as the reference ADDITIVE_MODE
+ *			 buffer does.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : load(), scan_ctx(), check_same(), sc_free(), unload(), b_share(), b_free(), memset(), printf()
+ *	Parameters : name: const char*, name of the source
+ *				 src: const char*, the source
+ *				 n: size_t, chars of the source
+ *	Return value : int, the number of modes that failed
+ *	Algorithm : MULTIPLICATIVE_MODE, FIXED_MODE, READONLY_MODE (mapped) and GAP_MODE are contiguous and padded,
+ *				SEGMENTED_MODE and STREAM_MODE (a small ring, read from the file or fed by the loader) take
+ *				the checked path of the scanner. The shared cursor comes last, it freezes the reference buffer.
+ */
+static int check_modes(const char* name, const char* src, size_t n)
+{
+	Loaded ref_buf, l; /* the reference buffer and the one of a mode */
+	Scan ref = { 0 }, s; /* the reference scan and the one of a mode */
+	pBuffer cursor; /* a shared cursor of the reference buffer */
+	int failed = 0; /* # of modes that failed */
+	size_t i; /* mode index */
+
+	if (load(&ref_buf, src, n, 'a') != 0 || scan_ctx(ref_buf.buf, n, NULL, &ref) != 0) {
+		printf("%s: the reference scan failed\n", name);
+		sc_free(&ref);
+		unload(&ref_buf);
+		return 1;
+	}
+	for (i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+		memset(&s, 0, sizeof(s));
+		if (load(&l, src, n, modes[i].mode) != 0 || scan_ctx(l.buf, n, NULL, &s) != 0) {
+			printf("%s, %s: the scan failed\n", name, modes[i].name);
+			++failed;
+		}
+		else
+			failed += check_same(name, modes[i].name, &ref, &s);
+		sc_free(&s);
+		unload(&l);
+	}
+	memset(&s, 0, sizeof(s));
+	if ((cursor = b_share(ref_buf.buf)) == NULL || scan_ctx(cursor, n, NULL, &s) != 0) {
+		printf("%s, shared cursor: the scan failed\n", name);
+		++failed;
+	}
+	else
+		failed += check_same(name, "shared cursor", &ref, &s);
+	sc_free(&s);
+	b_free(cursor);
+	sc_free(&ref);
+	unload(&ref_buf);
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks that every VID of a source with more names than a short can index gets the symbol of
+ *			 its name, scanned one token at a time, unpacked from a token stream and read back from the
+ *			 token cache.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : malloc(), sprintf(), load(), st_init(), ts_init(), b_allocate(), scan_ctx(), scan_batches(),
+ *					   scan_stream(), check_same(), check_cache(), st_name(), strcmp(), printf(), sc_free(),
+ *					   ts_free(), st_free(), b_free(), unload(), free()
+ *	Parameters : None
+ *	Return value : int, the number of checks that failed
+ *	Algorithm : The source assigns MANY_NAMES distinct names v00000, v00001, ... in turn, so the k-th VID
+ *				is the first occurrence of the k-th name and must have symbol index k.
+ */
+static int check_symbols(void)
+{
+	char* src = (char*)malloc(MANY_NAMES * 9 + 16); /* the source, "vNNNNN=1;" per name */
+	size_t n; /* chars of the source */
+	Loaded l = { 0 }; /* the source */
+	Scan ref = { 0 }, s = { 0 }; /* the scan one token at a time and the unpacked stream */
+	SymbolTable st_ref, st; /* their symbol tables */
+	TokenStream ts; /* the stream */
+	pBuffer str = NULL; /* its string literal table */
+	int k = 0; /* index of the next VID */
+	size_t i; /* token index */
+	int failed = 0; /* # of checks that failed */
+
+	st_init(&st_ref);
+	st_init(&st);
+	ts_init(&ts);
+	if (src == NULL) {
+		printf("many names: out of memory\n");
+		return 1;
+	}
+	n = sprintf(src, "PLATYPUS{");
+	for (i = 0; i < MANY_NAMES; ++i)
+		n += sprintf(src + n, "v%05u=1;", (unsigned)i);
+	n += sprintf(src + n, "}");
+	if (load(&l, src, n, 'a') != 0 || scan_ctx(l.buf, n, &st_ref, &ref) != 0
+		|| (str = b_allocate(100, 100, 'm')) == NULL || scan_batches(l.buf, &st, str, &ts) != 0) {
+		printf("many names: the scans failed\n");
+		++failed;
+	}
+	else {
+		for (i = 0; i < ref.count; ++i) {
+			if (ref.token[i].code != AVID_T)
+				continue;
+			if (!(ref.token[i].avid_attribute.flags & AV_SYMBOL) || ref.token[i].avid_attribute.values.int_value != k
+				|| strcmp(st_name(&st_ref, k), ref.token[i].attribute.vid_lex) != 0) {
+				printf("many names: %s doesn't have symbol %d\n", ref.token[i].attribute.vid_lex, k);
+				++failed;
+				break;
+			}
+			++k;
+		}
+		if (k != MANY_NAMES || st_ref.count != MANY_NAMES) {
+			printf("many names: %d VIDs and %u symbols, not %d\n", k, (unsigned)st_ref.count, MANY_NAMES);
+			++failed;
+		}
+		s.str = str;
+		failed += scan_stream(&ts, &s) != 0 || check_same("many names", "token stream with symbols", &ref, &s);
+		s.str = NULL;	/* borrowed */
+		failed += check_cache("many names", src, n, &ts, str);
+	}
+	sc_free(&ref);
+	sc_free(&s);
+	ts_free(&ts);
+	st_free(&st_ref);
+	st_free(&st);
+	b_free(str);
+	unload(&l);
+	free(src);
+	return failed;
+}
+
+
+/*
+ *	Purpose: Checks that the parallel scan of a source of a few chunks gives the stream of the serial scan.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0
+ *	Called functions : malloc(), gen_source(), load(), st_init(), ts_init(), b_allocate(), scan_batches(),
+ *					   ps_chunks(), malar_scan_parallel(), same_streams(), printf(), ts_free(), st_free(),
+ *					   b_free(), unload(), free()
+ *	Parameters : None
+ *	Return value : int, the number of scans that failed
+ *	Algorithm : The source is generated seed after seed up to BIG_SIZE chars, then scanned in parallel
+ *				from an ADDITIVE_MODE and a mapped READONLY_MODE buffer with 2 to 4 threads. The serial
+ *				scan of a SEGMENTED_MODE buffer, which has tokens across the ends of its segments, must
+ *				give the stream of the serial one too.
+ */
+static int check_parallel(void)
+{
+	char* src = (char*)malloc(BIG_SIZE); /* the source */
+	size_t n = 0; /* chars of the source */
+	unsigned long seed = 1; /* seed of the next part */
+	Loaded l; /* the source for the serial scan, then for each parallel one */
+	TokenStream ts, ts2; /* the serial and the parallel stream */
+	SymbolTable st, st2; /* their symbol tables */
+	pBuffer str = NULL, str2 = NULL; /* their string literal tables */
+	int threads; /* threads of the parallel scan */
+	int failed = 0; /* # of scans that failed */
+
+	if (src == NULL)
+		return 1;
+	while (n + GEN_MAX < BIG_SIZE)
+		n += gen_source(src + n, GEN_MAX, seed++);
+	ts_init(&ts);
+	st_init(&st);
+	if (load(&l, src, n, 'a') != 0 || (str = b_allocate(100, 100, 'm')) == NULL || scan_batches(l.buf, &st, str, &ts) != 0) {
+		printf("parallel scan: the serial scan failed\n");
+		++failed;
+	}
+	unload(&l);
+	ts_init(&ts2);
+	st_init(&st2);
+	if (failed == 0 && (load(&l, src, n, 's') != 0 || (str2 = b_allocate(100, 100, 'm')) == NULL
+		|| scan_batches(l.buf, &st2, str2, &ts2) != 0 || same_streams(&ts, str, &ts2, str2) != 0)) {
+		printf("parallel scan: the serial scan of SEGMENTED_MODE differs\n");
+		++failed;
+	}
+	ts_free(&ts2);
+	st_free(&st2);
+	b_free(str2);
+	str2 = NULL;
+	unload(&l);
+	for (threads = 2; threads <= 4 && failed == 0; ++threads) {
+		ts_init(&ts2);
+		st_init(&st2);
+		if (ps_chunks(n, threads) < 2)
+			printf("parallel scan: %d threads make a single chunk\n", threads), ++failed;
+		else if (load(&l, src, n, threads == 3 ? 'r' : 'a') != 0 || (str2 = b_allocate(100, 100, 'm')) == NULL
+			|| malar_scan_parallel(l.buf, &ts2, str2, &st2, threads) != 0)
+			printf("parallel scan: the scan with %d threads failed\n", threads), ++failed;
+		else if (same_streams(&ts, str, &ts2, str2) != 0)
+			printf("parallel scan: the stream of %d threads differs from the serial one\n", threads), ++failed;
+		ts_free(&ts2);
+		st_free(&st2);
+		b_free(str2);
+		str2 = NULL;
+		unload(&l);
+	}
+	ts_free(&ts);
+	st_free(&st);
+	b_free(str);
+	free(src);
+	return failed;
+}
+
+
+/* Compares two token streams with their lexeme tables, symbol tables and string literal tables.
+   Returns 0 if they are the same, 1 if not */
+static int same_streams(pTokenStream a, pBuffer a_str, pTokenStream b, pBuffer b_str) {
+	pBuffer tables[6]; /* lexemes, names and string literals of a then b */
+	size_t n; /* chars of a table */
+	size_t i; /* token, symbol or table index */
+
+	if (a->count != b->count || (a->symbols == NULL) != (b->symbols == NULL)
+		|| (a->symbols != NULL && a->symbols->count != b->symbols->count))
+		return 1;
+	for (i = 0; i < a->count; ++i)
+		if (a->token[i].code != b->token[i].code || a->token[i].flags != b->token[i].flags || a->token[i].value != b->token[i].value
+			|| a->token[i].offset != b->token[i].offset || a->token[i].length != b->token[i].length || a->line[i] != b->line[i])
+			return 1;
+	for (i = 0; a->symbols != NULL && i < a->symbols->count; ++i)
+		if (a->symbols->records[i].name != b->symbols->records[i].name || a->symbols->records[i].line != b->symbols->records[i].line
+			|| a->symbols->records[i].attr.flags != b->symbols->records[i].attr.flags)
+			return 1;
+	tables[0] = a->lexemes.chars;
+	tables[1] = a->symbols != NULL ? a->symbols->names.chars : NULL;
+	tables[2] = a_str;
+	tables[3] = b->lexemes.chars;
+	tables[4] = b->symbols != NULL ? b->symbols->names.chars : NULL;
+	tables[5] = b_str;
+	for (i = 0; i < 3; ++i) {
+		n = tables[i] != NULL ? b_limit(tables[i]) : 0;
+		if ((tables[i + 3] != NULL ? b_limit(tables[i + 3]) : 0) != n
+			|| (n > 0 && memcmp(b_view(tables[i], 0, n, NULL), b_view(tables[i + 3], 0, n, NULL), n) != 0))
+			return 1;
+	}
+	return 0;
+}
+
+
+/* Prints the tokens of the reference scan of a source, one per line */
+static void dump(const char* name, const char* src, size_t n) {
+	Loaded l; /* the source */
+	Scan s = { 0 }; /* its scan */
+	Token* t; /* a token */
+	unsigned int bits; /* bits of an FPL */
+	size_t i; /* token index */
+
+	printf("# %s\n", name);
+	if (load(&l, src, n, 'a') == 0 && scan_ctx(l.buf, n, NULL, &s) == 0)
+		for (i = 0; i < s.count; ++i) {
+			t = &s.token[i];
+			printf("%d L%d @%u ", t->code, s.line[i], (unsigned)s.offset[i]);
+			switch (t->code) {
+			case AVID_T: case SVID_T: printf("[%s]\n", t->attribute.vid_lex); break;
+			case ERR_T: case RTE_T: printf("[%s]\n", t->attribute.err_lex); break;
+			case FPL_T: memcpy(&bits, &t->attribute.flt_value, sizeof(bits)); printf("0x%08X\n", bits); break;
+			case STR_T: printf("\"%s\"\n", b_view(s.str, t->attribute.str_offset, 1, NULL)); break;
+			default: printf("%d\n", t->attribute.get_int);
+			}
+		}
+	else
+		printf("the scan failed\n");
+	sc_free(&s);
+	unload(&l);
+}
+
+
+/* Appends a token to a scan. Returns 0 on success, 1 if the scan can't grow */
+static int sc_add(Scan* s, const Token* t, int line, size_t offset) {
+	size_t capacity = s->capacity ? 2 * s->capacity : 64; /* the new capacity */
+	void* p; /* a grown array */
+
+	if (s->count == s->capacity) {
+		if ((p = realloc(s->token, capacity * sizeof(Token))) == NULL) return 1;
+		s->token = (Token*)p;
+		if ((p = realloc(s->line, capacity * sizeof(int))) == NULL) return 1;
+		s->line = (int*)p;
+		if ((p = realloc(s->offset, capacity * sizeof(size_t))) == NULL) return 1;
+		s->offset = (size_t*)p;
+		s->capacity = capacity;
+	}
+	s->token[s->count] = *t;
+	s->line[s->count] = line;
+	s->offset[s->count++] = offset;
+	return 0;
+}
+
+
+/* Frees the arrays and the string literal table of a scan and leaves it empty */
+static void sc_free(Scan* s) {
+	b_free(s->str);
+	free(s->token);
+	free(s->line);
+	free(s->offset);
+	memset(s, 0, sizeof(*s));
+}
+
+
+/* Compares two tokens by their code, the attribute of the code and the avid_attribute. Returns 1 if they are the same */
+static int tok_same(const Token* a, const Token* b) {
+	if (a->code != b->code || a->avid_attribute.flags != b->avid_attribute.flags
+		|| (a->avid_attribute.flags & AV_SYMBOL && a->avid_attribute.values.int_value != b->avid_attribute.values.int_value))
+		return 0;
+	switch (a->code) {
+	case AVID_T: case SVID_T: return strcmp(a->attribute.vid_lex, b->attribute.vid_lex) == 0;
+	case ERR_T: case RTE_T: return strcmp(a->attribute.err_lex, b->attribute.err_lex) == 0;
+	case FPL_T: return memcmp(&a->attribute.flt_value, &b->attribute.flt_value, sizeof(a->attribute.flt_value)) == 0;
+	case STR_T: return a->attribute.str_offset == b->attribute.str_offset;
+	default: return a->attribute.get_int == b->attribute.get_int;
+	}
+}
+
+
+/* The next number of a linear congruential generator, 15 bits */
+static unsigned int rnd(void) {
+	rng = rng * 1103515245UL + 12345UL;
+	return (unsigned int)(rng >> 16) & 0x7FFF;
+}
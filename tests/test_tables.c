@@ -0,0 +1,99 @@
+/*
+ *	File name: test_tables.c
+ *	Compiler: gcc / clang, built and run by "make test"
+ *	Author: Alex Carrozzi
+ *	Date: October 16th, 2026
+ *	Purpose: Checks the precomputed scanner tables of table.c against the definitions they were derived from.
+ *			 cc_table must give, for each of the 256 byte values, the transition table column the old
+ *			 char_class() function computed, and tt_table must be st_table with the TT_ACCEPT and TT_RETRACT
+ *			 flags as_table gives the next state. Exits with EXIT_FAILURE and lists the entries that differ.
+ *
+ *	Function list:  main()
+ *			char_class()
+ *			check_cc_table()
+ *			check_tt_table()
+ */
+
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* EXIT_SUCCESS, EXIT_FAILURE */
+#include <ctype.h>  /* isalpha(), isdigit() */
+
+#include "table.h"
+
+/* the globals the scanner expects its driver program to define (see platy.c) */
+pBuffer str_LTBL;
+int scerrnum;
+
+static int char_class(char c);
+static int check_cc_table(void);
+static int check_tt_table(void);
+
+
+/* Runs every check, returns EXIT_FAILURE if one of them fails */
+int main(void) {
+	int failed = 0; /* # of entries that differ */
+
+	failed += check_cc_table();
+	failed += check_tt_table();
+	printf("test_tables: %s\n", failed ? "FAILED" : "passed");
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/*
+ *	Purpose: The column of the transition table for c, as the scanner computed it before cc_table.
+ *	Author : Alex Carrozzi
+ *	History / Versions: 1.0 (the scanner's char_class() of version 1.0, kept as the reference)
+ *	Called functions : isalpha(), isdigit()
+ *	Parameters : c: char, the char to classify
+ *	Return value : int, the column of the transition table
+ *	Algorithm : N/A
+ */
+static int char_class(char c)
+{
+	if (isalpha(c))	return 0;
+	if (c == '0')	return 1;
+	if (isdigit(c))	return 2;
+	if (c == '.')	return 3;
+	if (c == '@')	return 4;
+	if (c == '"')	return 5;
+	if (c == EOF || c == SEOB) return 6;
+	return 7;	/* other */
+}
+
+
+/* Compares cc_table with char_class() for all 256 byte values, returns the # that differ */
+static int check_cc_table(void) {
+	int b; /* byte value */
+	int failed = 0; /* # of byte values that differ */
+
+	for (b = 0; b < 256; ++b)
+		if (cc_table[b] != char_class((char)b)) {
+			printf("cc_table[%d] is %d, char_class() gives %d\n", b, cc_table[b], char_class((char)b));
+			++failed;
+		}
+	return failed;
+}
+
+
+/* Compares tt_table with st_table and as_table for every transition, returns the # that differ */
+static int check_tt_table(void) {
+	int s, col; /* state and column */
+	int next; /* next state of st_table */
+	int packed; /* what tt_table should hold */
+	int failed = 0; /* # of transitions that differ */
+
+	for (s = 0; s < TABLE_ROWS; ++s)
+		for (col = 0; col < TABLE_COLUMNS; ++col) {
+			next = st_table[s][col];
+			if (next == IS)
+				packed = TT_IS;
+			else
+				packed = next | (as_table[next] != NOAS ? TT_ACCEPT : 0) | (as_table[next] == ASWR ? TT_RETRACT : 0);
+			if ((next != IS && next >= TT_IS) || tt_table[s][col] != packed) {
+				printf("tt_table[%d][%d] is 0x%02X, st_table and as_table give 0x%02X\n", s, col, tt_table[s][col], packed);
+				++failed;
+			}
+		}
+	return failed;
+}
@@ -9,6 +9,8 @@
 #ifndef TOKEN_H_
 #define TOKEN_H_
 
+#include <stddef.h> /* size_t */
+
  /*#pragma warning(1:4001) *//*to enforce C89 type comments  - to make //comments an warning */
 
  /*#pragma warning(error:4001)*//* to enforce C89 comments - to make // comments an error */
@@ -60,7 +62,7 @@ typedef union TokenAttribute {
 	S_Eof seof;        /* source-end-of-file attribute code */
 	int int_value;    /* integer literal attribute (value) */
 	int kwt_idx;      /* keyword index in the keyword table */
-	short str_offset; /* sring literal offset from the beginning of the string literal buffer (str_LTBL->cb_head) */
+	size_t str_offset; /* sring literal offset from the beginning of the string literal buffer (str_LTBL->cb_head) */
 	float flt_value;    /* floating-point literal attribute (value) */
 	char vid_lex[VID_LEN + 1]; /* variable identifier token attribute */
 	char err_lex[ERR_LEN + 1]; /* error token attribite */
@@ -69,7 +71,7 @@ typedef union TokenAttribute {
 typedef struct AdditionalVidTokenAttibutes {
 	unsigned char flags;
 	union {
-		short int_value;
+		int int_value;
 		float flt_value;
 		void* str_locator;
 	} values;